@@ -0,0 +1,70 @@
+/*
+ * bisimulation_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Minimizing the LTS of scalable CCS families: n interleaved processes performing distinct actions, which do not
+ * shrink, n replicated processes, which do under strong bisimulation, and n processes whose actions are preceded by
+ * internal handshakes, which shrink further under branching and weak bisimulation
+ */
+
+#include "workloads.h"
+#include <operational_semantics/bisimulation.h>
+#include <cstdlib>
+
+using semantics_type = small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>>;
+using lts_type = compact_lts<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>>;
+
+static const char* equivalence_name(bisimulation equivalence) {
+    switch (equivalence) {
+        case bisimulation::strong: return "strong";
+        case bisimulation::branching: return "branching";
+        case bisimulation::weak: return "weak";
+    }
+    return "";
+}
+
+static void minimize_family(const char* name, const std::shared_ptr<finite_ccs>& process) {
+    semantics_type semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    semantics.visit(process);
+    lts_type lts;
+    double compacting = time_ms([&]() { lts = semantics.compact(); }, 3);
+    std::cout << name << ": " << lts.state_count() << " states, " << lts.edge_count() << " edges, compacted in "
+              << compacting << " ms" << std::endl;
+    auto tau = lts.find_label({false, "."});
+    for (auto equivalence : {bisimulation::strong, bisimulation::branching, bisimulation::weak}) {
+        lts_quotient<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> quotient;
+        double elapsed = time_ms([&]() { quotient = minimize(lts, equivalence, tau); }, 3);
+        std::cout << "  " << equivalence_name(equivalence) << ": " << quotient.lts.state_count() << " classes, "
+                  << quotient.lts.edge_count() << " edges in " << elapsed << " ms ("
+                  << ((double)lts.state_count() / (double)std::max<std::size_t>(quotient.lts.state_count(), 1))
+                  << "x fewer states)" << std::endl;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 6;
+    size_t depth = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 3;
+    minimize_family("interleaved", interleaved_processes(n, depth));
+    minimize_family("replicated", replicated_processes(n, depth));
+    minimize_family("handshaking", handshaking_processes(n, depth));
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * bytecode_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Evaluating random expressions over many instances of their leaves: through the rules, one instance at a time, and
+ * through the compiled bytecode, either one instance at a time or in batches by the scalar and the AVX2 kernels.
+ * The leaves range over small numbers, so that some instances subtract a greater number or divide by zero, and all
+ * the evaluations are checked to agree on which instances are defined, and on their values
+ */
+
+#include "workloads.h"
+#include "../examples/uint_arithmetics_bytecode.h"
+#include <cstdlib>
+
+static void collect_leaves(const std::shared_ptr<num_op>& t, std::vector<std::shared_ptr<num_op>>& leaves) {
+    std::vector<std::shared_ptr<num_op>> pending{t};
+    while (!pending.empty()) {
+        auto x = pending.back();
+        pending.pop_back();
+        if (!x)
+            continue;
+        if (x->casus == VAL)
+            leaves.emplace_back(x);
+        pending.emplace_back(x->right);
+        pending.emplace_back(x->left);
+    }
+}
+
+/**
+ * @param leaves    Leaves of the expression, which are the inputs of the compiled one
+ * @param range     Inputs are drawn from [0, range)
+ */
+static void compare(const std::string& name, const std::shared_ptr<num_op>& expression,
+                    const std::vector<std::shared_ptr<num_op>>& leaves, size_t range, size_t count, size_t checked) {
+    std::mt19937_64 gen{count};
+    auto program = compile_uint_arithmetics(expression, leaves);
+    std::vector<size_t> values(leaves.size() * count);
+    for (auto& x : values)
+        x = gen() % range;
+
+    // Through the rules, by setting the leaves of each instance
+    language_semantics<num_op, std::string, size_t> transformer;
+    add_uint_arithmetics_rules(transformer);
+    transformer.set_discriminator(num_op_discriminator);
+    std::vector<std::optional<size_t>> expected(checked);
+    double rules = time_ms([&]() {
+        for (size_t i = 0; i<checked; i++) {
+            for (size_t k = 0; k<leaves.size(); k++)
+                leaves[k]->val = values[k * count + i];
+            auto result = transformer(expression);
+            expected[i] = result.empty() ? std::nullopt : std::optional<size_t>{*result[0].second};
+        }
+    }, 1);
+
+    std::vector<size_t> instance(leaves.size());
+    size_t mismatches = 0;
+    double single = time_ms([&]() {
+        for (size_t i = 0; i<checked; i++) {
+            for (size_t k = 0; k<leaves.size(); k++)
+                instance[k] = values[k * count + i];
+            mismatches += program(instance) != expected[i];
+        }
+    }, 1);
+
+    std::cout << name << " (" << leaves.size() << " inputs, " << program.code.size() << " instructions, "
+              << program.registers << " registers): rules " << (rules * 1e6 / (double)checked) << " ns/instance, "
+              << "bytecode " << (single * 1e6 / (double)checked) << " ns/instance";
+    std::vector<size_t> results(count);
+    std::vector<std::uint8_t> defined(count);
+    for (auto kernel : {uint_kernel::scalar, uint_kernel::avx2}) {
+        if ((kernel == uint_kernel::avx2) && (!uint_program::avx2_supported()))
+            continue;
+        double batch = time_ms([&]() { program(values, count, results, defined, kernel); });
+        for (size_t i = 0; i<checked; i++)
+            mismatches += (defined[i] ? std::optional<size_t>{results[i]} : std::nullopt) != expected[i];
+        size_t undefined = std::count(defined.begin(), defined.end(), 0);
+        std::cout << ", " << ((kernel == uint_kernel::scalar) ? "scalar" : "AVX2") << " batch "
+                  << (batch * 1e6 / (double)count) << " ns/instance (" << undefined << " of " << count << " undefined)";
+    }
+    std::cout << (mismatches ? ", MISMATCHES: " + std::to_string(mismatches) : ", all agree") << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t count = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1 << 16;
+    size_t checked = std::min<size_t>(count, 4096);
+    // Subtracting and dividing by differences, so that both masks are exercised
+    std::vector<std::shared_ptr<num_op>> xs;
+    for (size_t k = 0; k<4; k++)
+        xs.emplace_back(std::make_shared<num_op>(k));
+    auto ratio = std::make_shared<num_op>(std::make_shared<num_op>(xs[0], MINUS, xs[1]), DIV,
+                                          std::make_shared<num_op>(xs[2], MINUS, xs[3]));
+    compare("(x - y) / (z - w)", ratio, xs, 4, count, checked);
+
+    // Random expressions, dividing by one of 64 values, one of which is zero
+    for (size_t nodes : {7, 31, 127, 511}) {
+        std::mt19937_64 gen{nodes};
+        auto expression = random_expression(gen, nodes);
+        std::vector<std::shared_ptr<num_op>> leaves;
+        collect_leaves(expression, leaves);
+        compare(std::to_string(nodes) + " nodes", expression, leaves, 64, count, checked);
+    }
+
+    // Deep expressions are compiled without recursion, into as few registers as their shape allows
+    auto deep = left_deep_sum(1000000);
+    auto program = compile_uint_arithmetics(deep);
+    std::cout << "left-deep sum of 1000000 additions: " << program.code.size() << " instructions, "
+              << program.registers << " registers, value " << program().value_or(0) << std::endl;
+    release(std::move(deep));
+    return 0;
+}
@@ -0,0 +1,189 @@
+/*
+ * cott_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmark suite over scalable workload families, writing one JSON object per line, so that the results can be
+ * tracked over time:
+ *
+ *  - the state spaces of dining philosophers, token rings, interleaved processes, and synchronising processes under
+ *    restriction, for which the states/s and the bytes/state are measured, as well as the scaling across threads of
+ *    the largest instance of each family;
+ *  - the evaluation of random and left-deep arithmetic expressions, for which the ns/node are measured.
+ *
+ * Usage: cott_bench [--quick] [--max-nodes N] [--max-threads T] [--output FILE]
+ */
+
+#include "workloads.h"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+/**
+ * Fields of a JSON object, written on a single line
+ */
+struct json_record {
+    json_record& add(const char* key, const std::string& value) {
+        std::string quoted = "\"";
+        for (char c : value) {
+            if ((c == '"') || (c == '\\'))
+                quoted += '\\';
+            quoted += c;
+        }
+        fields.emplace_back(key, quoted + "\"");
+        return *this;
+    }
+
+    json_record& add(const char* key, const char* value) {
+        return add(key, std::string{value});
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+    json_record& add(const char* key, T value) {
+        std::ostringstream os;
+        os << value;
+        fields.emplace_back(key, os.str());
+        return *this;
+    }
+
+    void write(std::ostream& os) const {
+        os << '{';
+        for (size_t i = 0; i<fields.size(); i++)
+            os << (i ? "," : "") << '"' << fields[i].first << "\":" << fields[i].second;
+        os << '}' << std::endl;
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> fields;
+};
+
+struct ccs_family {
+    const char* name;
+    std::vector<size_t> sizes;
+    std::function<std::shared_ptr<finite_ccs>(size_t)> generate;
+};
+
+static void explore(const ccs_family& family, size_t max_threads, std::ostream& out) {
+    for (size_t size : family.sizes) {
+        auto process = family.generate(size);
+        small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> semantics;
+        add_finite_ccs_rules(semantics);
+        semantics.set_discriminator(finite_ccs_discriminator);
+        exploration_result result;
+        double elapsed = time_ms([&]() { result = semantics.visit(process); }, 3);
+        auto lts = semantics.compact();
+        json_record{}.add("suite", "ccs").add("family", family.name).add("size", size).add("threads", 1)
+                .add("states", result.states).add("edges", result.edges).add("ms", elapsed)
+                .add("states_per_second", 1000.0 * (double)result.states / elapsed)
+                .add("bytes_per_state", (double)result.memory / (double)result.states)
+                .add("compact_bytes_per_state", lts.bytes_per_state()).write(out);
+    }
+    // Scaling of the largest instance, against the multi-threaded exploration on a single thread
+    auto process = family.generate(family.sizes.back());
+    double single = 0.0;
+    for (size_t threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+        small_step_semantics<finite_ccs, std::pair<bool,std::string>> semantics;
+        add_finite_ccs_rules(semantics);
+        semantics.set_discriminator(finite_ccs_discriminator);
+        double elapsed = time_ms([&]() { semantics.parallel_visit(process, threads); }, 3);
+        if (threads == 1)
+            single = elapsed;
+        json_record{}.add("suite", "ccs_scaling").add("family", family.name).add("size", family.sizes.back())
+                .add("threads", threads).add("states", semantics.visited_nodes.size()).add("ms", elapsed)
+                .add("states_per_second", 1000.0 * (double)semantics.visited_nodes.size() / elapsed)
+                .add("speedup", single / elapsed).write(out);
+        if (threads >= max_threads)
+            break;
+    }
+}
+
+static size_t count_nodes(const std::shared_ptr<num_op>& t) {
+    size_t nodes = 0;
+    std::vector<const num_op*> S{t.get()};
+    while (!S.empty()) {
+        auto top = S.back();
+        S.pop_back();
+        nodes++;
+        for (const auto* child : {top->left.get(), top->right.get()})
+            if (child)
+                S.emplace_back(child);
+    }
+    return nodes;
+}
+
+static void evaluate(const char* family, size_t max_nodes, std::ostream& out) {
+    bool left_deep = std::strcmp(family, "left_deep") == 0;
+    for (size_t size = 1000; size <= max_nodes; size *= 10) {
+        std::mt19937_64 gen{42};
+        auto expression = left_deep ? left_deep_sum(size / 2) : random_expression(gen, size);
+        language_semantics<num_op, std::string, size_t> transformer;
+        add_uint_arithmetics_rules(transformer);
+        transformer.set_discriminator(num_op_discriminator);
+        if (left_deep)
+            transformer.limits.native_depth = 1024;
+        size_t value = 0;
+        double elapsed = time_ms([&]() { value = *transformer(expression)[0].second; }, 3);
+        size_t nodes = count_nodes(expression);
+        json_record{}.add("suite", "num_op").add("family", family).add("nodes", nodes).add("value", value)
+                .add("ms", elapsed).add("ns_per_node", elapsed * 1e6 / (double)nodes).write(out);
+        if (left_deep)
+            release(std::move(expression));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    bool quick = false;
+    size_t max_nodes = 1000000;
+    size_t max_threads = std::max(1u, std::thread::hardware_concurrency());
+    std::ofstream file;
+    for (int i = 1; i<argc; i++) {
+        if (std::strcmp(argv[i], "--quick") == 0)
+            quick = true;
+        else if ((std::strcmp(argv[i], "--max-nodes") == 0) && (i + 1 < argc))
+            max_nodes = std::strtoull(argv[++i], nullptr, 10);
+        else if ((std::strcmp(argv[i], "--max-threads") == 0) && (i + 1 < argc))
+            max_threads = std::max<size_t>(1, std::strtoull(argv[++i], nullptr, 10));
+        else if ((std::strcmp(argv[i], "--output") == 0) && (i + 1 < argc))
+            file.open(argv[++i]);
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--max-nodes N] [--max-threads T] [--output FILE]" << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = file.is_open() ? file : std::cout;
+    if (quick)
+        max_nodes = std::min<size_t>(max_nodes, 100000);
+
+    std::vector<ccs_family> families{
+            {"dining_philosophers", quick ? std::vector<size_t>{3, 4} : std::vector<size_t>{3, 4, 5, 6},
+             [](size_t n) { return dining_philosophers(n, 1); }},
+            {"token_ring", quick ? std::vector<size_t>{4, 6} : std::vector<size_t>{4, 6, 8, 10},
+             [](size_t n) { return token_ring(n, 2); }},
+            {"interleaved_processes", quick ? std::vector<size_t>{4, 5} : std::vector<size_t>{4, 5, 6, 7},
+             [](size_t n) { return interleaved_processes(n, 3); }},
+            {"synchronising_processes", quick ? std::vector<size_t>{2, 3} : std::vector<size_t>{2, 3, 4},
+             [](size_t n) { return synchronising_processes(n, 3); }},
+    };
+    for (const auto& family : families)
+        explore(family, max_threads, out);
+    evaluate("random", max_nodes, out);
+    evaluate("left_deep", max_nodes, out);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * deep_evaluation_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Evaluating left-deep expressions, which are too deep for the plain recursive evaluation
+ */
+
+#include "workloads.h"
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    language_semantics<num_op, std::string, size_t> transformer;
+    add_uint_arithmetics_rules(transformer);
+    transformer.set_discriminator(num_op_discriminator);
+    transformer.limits.native_depth = 1024;
+
+    auto expression = left_deep_sum(n);
+    auto start = std::chrono::steady_clock::now();
+    auto result = transformer(expression);
+    auto end = std::chrono::steady_clock::now();
+    double elapsed = std::chrono::duration<double, std::milli>(end - start).count();
+
+    std::cout << "left-deep sum of " << n << " additions: " << (result.empty() ? 0 : *result[0].second)
+              << " in " << elapsed << " ms (" << (elapsed * 1e6 / (double)n) << " ns/node)" << std::endl;
+    std::cout << "max depth " << transformer.statistics.max_depth
+              << ", max segments " << transformer.statistics.max_segments
+              << ", segment switches " << transformer.statistics.segment_switches
+              << ", segment bytes " << transformer.statistics.segment_bytes << std::endl;
+
+    transformer.limits.max_depth = n / 2;
+    transformer.statistics = {};
+    std::cout << "bounded to depth " << transformer.limits.max_depth << ": "
+              << (transformer(expression).empty() ? "ill-formed" : "evaluated")
+              << (transformer.statistics.depth_exceeded ? " (depth exceeded)" : "") << std::endl;
+    release(std::move(expression));
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+ * hash_quality_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Collision rates of the structural hashes over generated state spaces, and over random expressions alongside their
+ * mirrored ones: the XOR-based hashes previously shipped with the examples, against the ones built from
+ * hash_combine.h. For each, it reports the states sharing their full hash with another one, and the states sharing a
+ * bucket in a power-of-two table (indexed by the low bits) and in a prime-sized one (as std::unordered_set), against
+ * the ones expected from a uniform hash
+ */
+
+#include "workloads.h"
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <unordered_set>
+
+/**
+ * The hash of finite CCS processes as previously defined: XORs and sums of the children's hashes
+ */
+static std::size_t legacy_hash(const finite_ccs& x) {
+    std::hash<std::string> H;
+    switch (x.casus) {
+        case NIL:
+            return 1;
+        case MultiPrefix: {
+            size_t base_case = 13;
+            for (const auto& [k, v] : x.multi_prefix)
+                base_case += (((H(k.second) * 2 + (k.first ? 1 : 0))) ^ legacy_hash(*v))*7;
+            return base_case*8+4;
+        }
+        case ParallelComposition: {
+            size_t base_case = 17;
+            for (const auto& child : x.parallel_compose)
+                base_case = base_case * 31 + legacy_hash(*child);
+            return base_case*8+3;
+        }
+        case Restriction: {
+            size_t labels = 31;
+            for (const auto& k : x.restr_label)
+                labels += H(k) * 7;
+            return ((labels ^ legacy_hash(*x.parallel_compose[0])) * 8) + 2;
+        }
+    }
+    return 0;
+}
+
+/**
+ * The hash of expressions as previously defined, where mirrored expressions collide
+ */
+static std::size_t legacy_hash(const num_op& x) {
+    size_t lh = (x.left) ? legacy_hash(*x.left) *2+1 : 0;
+    size_t rh = (x.right) ? legacy_hash(*x.right) *2+1 : 0;
+    return ((size_t)x.casus) ^ (x.val) ^ (lh ^ rh);
+}
+
+static std::shared_ptr<num_op> mirror(const std::shared_ptr<num_op>& t) {
+    if (!t)
+        return nullptr;
+    if (t->casus == EXPR)
+        return std::make_shared<num_op>(mirror(t->left));
+    if ((t->casus == PLUS) || (t->casus == TIMES))
+        return std::make_shared<num_op>(mirror(t->right), t->casus, mirror(t->left));
+    return t;
+}
+
+/**
+ * Buckets shared by more than one of n uniformly hashed keys, i.e. n minus the expected occupied buckets
+ */
+static double expected_collisions(std::size_t n, std::size_t buckets) {
+    return (double)n - (double)buckets * (1.0 - std::pow(1.0 - 1.0 / (double)buckets, (double)n));
+}
+
+struct bucket_statistics {
+    std::size_t colliding = 0;      ///< Keys not alone in their bucket, beyond the first one
+    std::size_t longest = 0;        ///< Longest chain
+    double expected = 0.0;
+};
+
+template <typename Index>
+static bucket_statistics buckets_of(const std::vector<std::size_t>& hashes, std::size_t buckets, Index&& index) {
+    std::vector<std::uint32_t> chains(buckets, 0);
+    bucket_statistics result;
+    for (auto h : hashes) {
+        auto& chain = chains[index(h)];
+        result.colliding += chain > 0;
+        result.longest = std::max<std::size_t>(result.longest, ++chain);
+    }
+    result.expected = expected_collisions(hashes.size(), buckets);
+    return result;
+}
+
+static void report(const std::string& workload, const char* hash, const std::vector<std::size_t>& hashes) {
+    std::unordered_set<std::size_t> distinct{hashes.begin(), hashes.end()};
+    std::size_t n = hashes.size();
+    std::size_t mask = std::bit_ceil(n) - 1;
+    std::unordered_set<std::size_t> sized;
+    sized.reserve(n);
+    std::size_t prime = sized.bucket_count();
+    auto low = buckets_of(hashes, mask + 1, [mask](std::size_t h) { return h & mask; });
+    auto modulo = buckets_of(hashes, prime, [prime](std::size_t h) { return h % prime; });
+    std::cout << std::left << std::setw(28) << workload << std::setw(10) << hash << std::right
+              << " states " << std::setw(7) << n
+              << "  full collisions " << std::setw(7) << (n - distinct.size())
+              << "  pow2 buckets " << std::setw(7) << low.colliding << " (uniform " << std::setw(7) << (std::size_t)low.expected
+              << ", longest " << std::setw(5) << low.longest << ")"
+              << "  prime buckets " << std::setw(7) << modulo.colliding << " (uniform " << std::setw(7) << (std::size_t)modulo.expected
+              << ", longest " << std::setw(5) << modulo.longest << ")" << std::endl;
+}
+
+template <typename Node, typename Legacy>
+static void compare(const std::string& workload, const std::vector<std::shared_ptr<Node>>& states, Legacy&& legacy) {
+    std::vector<std::size_t> old_hashes, new_hashes;
+    KeyHasher<Node> hasher;
+    for (const auto& t : states) {
+        // As previously hashed by KeyHasher, on top of the legacy hash
+        old_hashes.emplace_back(legacy(*t) * 2 + 1);
+        new_hashes.emplace_back(hasher(t));
+    }
+    report(workload, "legacy", old_hashes);
+    report(workload, "combined", new_hashes);
+}
+
+static void ccs_family(const std::string& name, const std::shared_ptr<finite_ccs>& process) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    semantics.visit(process);
+    std::vector<std::shared_ptr<finite_ccs>> states{semantics.visited_nodes.begin(), semantics.visited_nodes.end()};
+    compare(name, states, [](const finite_ccs& x) { return legacy_hash(x); });
+}
+
+/**
+ * Distinct subexpressions of random expressions, alongside their mirrored ones
+ */
+static void expressions(std::size_t count, std::size_t nodes) {
+    std::mt19937_64 gen{42};
+    transition_node_set<num_op> distinct;
+    std::vector<std::shared_ptr<num_op>> pending;
+    for (std::size_t i = 0; i<count; i++) {
+        auto t = random_expression(gen, nodes);
+        pending.emplace_back(t);
+        pending.emplace_back(mirror(t));
+    }
+    while (!pending.empty()) {
+        auto t = pending.back();
+        pending.pop_back();
+        if (t && distinct.emplace(t).second) {
+            pending.emplace_back(t->left);
+            pending.emplace_back(t->right);
+        }
+    }
+    std::vector<std::shared_ptr<num_op>> states{distinct.begin(), distinct.end()};
+    compare("expressions_" + std::to_string(nodes), states, [](const num_op& x) { return legacy_hash(x); });
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 5;
+    ccs_family("dining_philosophers_" + std::to_string(n), dining_philosophers(n, 1));
+    ccs_family("token_ring_" + std::to_string(n + 3), token_ring(n + 3, 2));
+    ccs_family("interleaved_processes_" + std::to_string(n), interleaved_processes(n, 3));
+    ccs_family("synchronising_processes_" + std::to_string(n - 2), synchronising_processes(n - 2, 3));
+    expressions(2000, 64);
+    return 0;
+}
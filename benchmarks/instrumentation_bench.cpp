@@ -0,0 +1,59 @@
+/*
+ * instrumentation_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Profiling the rules of the two examples, and reporting the progress of the exploration of n interleaved CCS
+ * processes. This is built with the instrumentation enabled, and linked with the allocator counting the allocations
+ */
+
+#include "workloads.h"
+#include <cstdlib>
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 8;
+    size_t depth = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 3;
+    {
+        language_semantics<num_op, std::string, size_t> transformer;
+        add_uint_arithmetics_rules(transformer);
+        transformer.set_discriminator(num_op_discriminator);
+        std::mt19937_64 gen{42};
+        size_t sum = 0;
+        for (size_t i = 0; i<100; i++)
+            sum += *transformer(random_num_op(gen, 5000))[0].second;
+        std::cout << "uint_arithmetics (" << sum << "): ";
+        transformer.profile.write_json(std::cout);
+        std::cout << std::endl;
+    }
+    {
+        small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> semantics;
+        add_finite_ccs_rules(semantics);
+        semantics.set_discriminator(finite_ccs_discriminator);
+        semantics.telemetry.every = std::chrono::milliseconds{50};
+        semantics.telemetry.on_progress = [](const exploration_progress& progress) {
+            std::cout << "progress: ";
+            progress.write_json(std::cout);
+            std::cout << std::endl;
+        };
+        semantics.visit(interleaved_processes(n, depth));
+        std::cout << "finite_ccs: ";
+        semantics.write_telemetry(std::cout);
+    }
+    return 0;
+}
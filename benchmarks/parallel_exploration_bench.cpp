@@ -0,0 +1,87 @@
+/*
+ * parallel_exploration_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Scaling of the multi-threaded exploration from 1 to N threads over n interleaved CCS processes, each performing depth
+ * actions, checking that each run generates the same graph as the sequential visit
+ */
+
+#include "workloads.h"
+#include <cstdlib>
+
+using semantics_type = small_step_semantics<finite_ccs, std::pair<bool,std::string>>;
+
+static size_t count_edges(const semantics_type& semantics) {
+    size_t edges = 0;
+    for (const auto& [src, adj] : semantics.forward_transition_graph)
+        for (const auto& [label, dst] : adj)
+            edges += dst.size();
+    return edges;
+}
+
+static bool same_graph(const semantics_type& x, const semantics_type& y) {
+    if ((x.visited_nodes.size() != y.visited_nodes.size()) ||
+        (x.forward_transition_graph.size() != y.forward_transition_graph.size()))
+        return false;
+    for (const auto& t : x.visited_nodes)
+        if (!y.visited_nodes.contains(t))
+            return false;
+    for (const auto& [src, adj] : x.forward_transition_graph) {
+        auto it = y.forward_transition_graph.find(src);
+        if ((it == y.forward_transition_graph.end()) || (it->second.size() != adj.size()))
+            return false;
+        for (const auto& [label, dst] : adj) {
+            auto jt = it->second.find(label);
+            if ((jt == it->second.end()) || (jt->second.size() != dst.size()))
+                return false;
+            for (const auto& t : dst)
+                if (!jt->second.contains(t))
+                    return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 6;
+    size_t depth = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 3;
+    size_t max_threads = (argc > 3) ? std::strtoull(argv[3], nullptr, 10) : std::max(1u, std::thread::hardware_concurrency());
+    auto process = interleaved_processes(n, depth);
+
+    semantics_type reference;
+    add_finite_ccs_rules(reference);
+    reference.set_discriminator(finite_ccs_discriminator);
+    double sequential = time_ms([&]() { reference.visit(process); }, 3);
+    std::cout << "sequential: " << reference.visited_nodes.size() << " states, " << count_edges(reference)
+              << " edges in " << sequential << " ms" << std::endl;
+
+    for (size_t threads = 1; ; threads = std::min(threads * 2, max_threads)) {
+        semantics_type semantics;
+        add_finite_ccs_rules(semantics);
+        semantics.set_discriminator(finite_ccs_discriminator);
+        double elapsed = time_ms([&]() { semantics.parallel_visit(process, threads); }, 3);
+        std::cout << threads << " threads: " << semantics.visited_nodes.size() << " states, " << count_edges(semantics)
+                  << " edges in " << elapsed << " ms (speedup " << (sequential / elapsed) << "x, "
+                  << (same_graph(reference, semantics) ? "same graph" : "DIFFERENT GRAPH") << ")" << std::endl;
+        if (threads >= max_threads)
+            break;
+    }
+    return 0;
+}
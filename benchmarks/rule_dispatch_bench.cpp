@@ -0,0 +1,67 @@
+/*
+ * rule_dispatch_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Comparing the linear scan of the rules against the indexed dispatch over the two examples, as well as against
+ * the compile-time rule table for the arithmetics one
+ */
+
+#include "workloads.h"
+
+int main() {
+    {
+        language_semantics<num_op, std::string, size_t> transformer;
+        add_uint_arithmetics_rules(transformer);
+        std::mt19937_64 gen{42};
+        std::vector<std::shared_ptr<num_op>> terms;
+        for (size_t i = 0; i<200; i++)
+            terms.emplace_back(random_num_op(gen, 5000));
+        size_t sum[3];
+        auto evaluate_all = [&terms](auto& semantics, size_t& result) {
+            result = 0;
+            for (const auto& t : terms) result += *semantics(t)[0].second;
+        };
+        double linear = time_ms([&]() { evaluate_all(transformer, sum[0]); });
+        transformer.set_discriminator(num_op_discriminator);
+        double indexed = time_ms([&]() { evaluate_all(transformer, sum[1]); });
+        auto static_transformer = make_static_uint_arithmetics();
+        double compiled = time_ms([&]() { evaluate_all(static_transformer, sum[2]); });
+        std::cout << "uint_arithmetics: linear " << linear << " ms, indexed " << indexed << " ms, static "
+                  << compiled << " ms" << ((sum[0] == sum[1]) && (sum[1] == sum[2]) ? "" : " (MISMATCH)") << std::endl;
+    }
+    {
+        auto process = interleaved_processes(6, 3);
+        size_t states[2];
+        double elapsed[2];
+        for (bool indexed : {false, true}) {
+            elapsed[indexed] = time_ms([&]() {
+                small_step_semantics<finite_ccs, std::pair<bool,std::string>> semantics;
+                add_finite_ccs_rules(semantics);
+                if (indexed) semantics.set_discriminator(finite_ccs_discriminator);
+                semantics.visit(process);
+                states[indexed] = semantics.visited_nodes.size();
+            });
+        }
+        std::cout << "finite_ccs: " << states[1] << " states, linear " << elapsed[0]
+                  << " ms, indexed " << elapsed[1] << " ms"
+                  << (states[0] == states[1] ? "" : " (MISMATCH)") << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,288 @@
+/*
+ * state_space_bench.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Generating the LTS of n interleaved CCS processes, each performing depth actions, with the different storage
+ * policies for the states
+ */
+
+#include "workloads.h"
+#include <cstdlib>
+#include <unistd.h>
+
+template <typename NodeKeys>
+static void explore(const char* name, const std::shared_ptr<finite_ccs>& process, bool arena = false) {
+    size_t states = 0, edges = 0;
+    double elapsed = time_ms([&]() {
+        small_step_semantics<finite_ccs, std::pair<bool,std::string>, NodeKeys> semantics;
+        add_finite_ccs_rules(semantics);
+        semantics.set_discriminator(finite_ccs_discriminator);
+        if (arena)
+            semantics.arena = std::make_shared<term_arena>();
+        semantics.visit(process);
+        states = semantics.visited_nodes.size();
+        edges = 0;
+        for (const auto& [src, adj] : semantics.forward_transition_graph)
+            for (const auto& [label, dst] : adj)
+                edges += dst.size();
+    }, 3);
+    std::cout << name << ": " << states << " states, " << edges << " edges in " << elapsed << " ms ("
+              << ((double)states / elapsed * 1000.0) << " states/s)" << std::endl;
+}
+
+template <typename NodeKeys>
+static void explore_compact(const char* name, const std::shared_ptr<finite_ccs>& process) {
+    compact_lts<finite_ccs, std::pair<bool,std::string>, NodeKeys> lts;
+    double elapsed = time_ms([&]() {
+        small_step_semantics<finite_ccs, std::pair<bool,std::string>, NodeKeys> semantics;
+        add_finite_ccs_rules(semantics);
+        semantics.set_discriminator(finite_ccs_discriminator);
+        lts = semantics.visit_compact(process);
+    }, 3);
+    auto memory = lts.memory();
+    std::cout << name << ": " << lts.state_count() << " states, " << lts.edge_count() << " edges in " << elapsed
+              << " ms (" << ((double)lts.state_count() / elapsed * 1000.0) << " states/s, " << lts.bytes_per_state()
+              << " bytes/state: " << memory.states << " states, " << memory.index << " index, " << memory.labels
+              << " labels, " << memory.edges << " edges)" << std::endl;
+}
+
+static void explore_with(const char* name, const std::shared_ptr<finite_ccs>& process, const exploration_options& options) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    auto result = semantics.visit(process, options);
+    std::cout << name << ": " << to_string(result.status) << ", " << result.states << " states, " << result.edges
+              << " edges, " << result.expansions << " expansions, depth " << result.depth << ", ~" << result.memory
+              << " bytes in " << result.elapsed_ms << " ms" << std::endl;
+}
+
+static void explore_reduced(const char* name, const std::shared_ptr<finite_ccs>& process, bool reduced) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    if (reduced)
+        semantics.reduction.independent = finite_ccs_independent;
+    exploration_result result;
+    double elapsed = time_ms([&]() { result = semantics.visit(process); }, 3);
+    auto deadlock = semantics.find_deadlock(process);
+    std::cout << name << ": " << result.states << " states, " << result.edges << " edges, " << result.pruned
+              << " pruned transitions in " << elapsed << " ms, deadlock " << (deadlock.found() ? "found" : "not found")
+              << " after " << deadlock.exploration.states << " states" << std::endl;
+}
+
+static void explore_symmetric(const char* name, const std::shared_ptr<finite_ccs>& process, bool canonical) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    if (canonical)
+        semantics.canonicalize = canonical_form<finite_ccs>;
+    exploration_result result;
+    double elapsed = time_ms([&]() { result = semantics.visit(process); }, 3);
+    std::cout << name << ": " << result.states << " states, " << result.edges << " edges in " << elapsed << " ms" << std::endl;
+}
+
+/**
+ * @return  A new directory, only used by this run, for the files written by a benchmark, which removes it afterwards
+ */
+static std::filesystem::path private_directory() {
+    std::string name = (std::filesystem::temp_directory_path() / "cott_bench_XXXXXX").string();
+    if (!::mkdtemp(name.data()))
+        throw std::system_error(errno, std::generic_category(), name);
+    return name;
+}
+
+static void explore_external(const char* name, const std::shared_ptr<finite_ccs>& process) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    auto directory = private_directory();
+    {
+        disk_state_store<finite_ccs, std::pair<bool,std::string>> store(directory);
+        auto result = semantics.visit_external(process, store);
+        std::cout << name << ": " << result.states << " states, " << result.edges << " edges in " << result.elapsed_ms
+                  << " ms, " << ((double)store.memory() / (double)result.states) << " bytes/state in RAM, "
+                  << ((double)store.disk_usage() / (double)result.states) << " bytes/state on disk" << std::endl;
+    }
+    std::filesystem::remove_all(directory);
+}
+
+static void explore_compressed(const std::shared_ptr<finite_ccs>& process) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> interned;
+    add_finite_ccs_rules(interned);
+    interned.set_discriminator(finite_ccs_discriminator);
+    auto baseline = interned.visit(process);
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    tree_compressed_store<finite_ccs, std::pair<bool,std::string>> store;
+    auto result = semantics.visit_external(process, store);
+    std::cout << "breadth-first, tree compressed: " << result.states << " states, " << result.edges << " edges in "
+              << result.elapsed_ms << " ms, " << store.subterm_count() << " subterms, " << store.bytes_per_state()
+              << " bytes/state, " << ((double)(store.memory() + store.edge_count() * sizeof(lts_transition)) / (double)result.states)
+              << " with the edges, against " << ((double)baseline.memory / (double)baseline.states)
+              << " bytes/state for the interned graph" << std::endl;
+}
+
+static void explore_bitstate(const char* name, const std::shared_ptr<finite_ccs>& process, std::size_t bytes) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    bitstate_filter filter(bytes);
+    auto result = semantics.visit_bitstate(process, filter);
+    std::cout << name << ": " << result.exploration.states << " states, " << result.exploration.edges << " edges in "
+              << result.exploration.elapsed_ms << " ms, " << filter.memory() << " bytes of bits, estimated coverage "
+              << result.coverage << ", omission probability " << result.omission_probability << std::endl;
+}
+
+static void checkpoint_and_resume(const std::shared_ptr<finite_ccs>& process) {
+    using semantics_type = small_step_semantics<finite_ccs, std::pair<bool,std::string>>;
+    using checkpoint_type = exploration_checkpoint<finite_ccs, std::pair<bool,std::string>>;
+    auto directory = private_directory();
+    auto path = directory / "cott_bench.ckpt";
+    semantics_type plain;
+    add_finite_ccs_rules(plain);
+    plain.set_discriminator(finite_ccs_discriminator);
+    auto baseline = plain.visit(process);
+    // Interrupting the exploration after half of the states, as a preemption would
+    semantics_type interrupted;
+    add_finite_ccs_rules(interrupted);
+    interrupted.set_discriminator(finite_ccs_discriminator);
+    interrupted.checkpoint = std::make_shared<checkpoint_type>(path, 256);
+    exploration_options half;
+    half.max_states = baseline.states / 2;
+    auto first = interrupted.visit(process, half);
+    semantics_type resumed;
+    add_finite_ccs_rules(resumed);
+    resumed.set_discriminator(finite_ccs_discriminator);
+    auto second = resumed.resume(std::make_shared<checkpoint_type>(path, 256));
+    bool same = (resumed.visited_nodes.size() == plain.visited_nodes.size()) &&
+                (resumed.forward_transition_graph.size() == plain.forward_transition_graph.size());
+    for (const auto& [src, adjacency] : plain.forward_transition_graph) {
+        auto it = resumed.forward_transition_graph.find(src);
+        same = same && (it != resumed.forward_transition_graph.end()) && (it->second.size() == adjacency.size());
+        for (const auto& [label, dst] : adjacency)
+            for (const auto& t : dst)
+                same = same && it->second.contains(label) && it->second.at(label).contains(t);
+    }
+    std::cout << "checkpointed every 256 expansions: " << first.elapsed_ms << " ms up to " << first.states
+              << " states, against " << baseline.elapsed_ms << " ms for all the " << baseline.states
+              << " states without checkpoints; resumed up to " << second.states << " states in " << second.elapsed_ms
+              << " ms, " << std::filesystem::file_size(path) << " bytes logged, "
+              << (same ? "same graph" : "different graph") << std::endl;
+    std::filesystem::remove_all(directory);
+}
+
+static std::string label_name(const std::pair<bool,std::string>& label) {
+    return (label.first ? "'" : "") + label.second;
+}
+
+static void export_and_reload(const std::shared_ptr<finite_ccs>& process) {
+    using semantics_type = small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>>;
+    auto directory = private_directory();
+    semantics_type semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    double streaming = time_ms([&]() {
+        aut_writer<finite_ccs, std::pair<bool,std::string>> aut(directory / "cott_bench.aut", label_name);
+        dot_writer<finite_ccs, std::pair<bool,std::string>> dot(directory / "cott_bench.dot", label_name);
+        auto to_aut = aut.listener(), to_dot = dot.listener();
+        semantics.listener.on_numbered_state = [&](std::size_t id, const std::shared_ptr<finite_ccs>& t) {
+            to_aut.on_numbered_state(id, t);
+            to_dot.on_numbered_state(id, t);
+        };
+        semantics.listener.on_numbered_edge = [&](std::size_t src, const std::pair<bool,std::string>& label, std::size_t dst) {
+            to_aut.on_numbered_edge(src, label, dst);
+            to_dot.on_numbered_edge(src, label, dst);
+        };
+        semantics.visit(process);
+        semantics.listener = {};
+    }, 3);
+    auto lts = semantics.compact();
+    double saving = time_ms([&]() { save_lts(directory / "cott_bench.lts", lts); }, 3);
+    size_t edges = 0;
+    double loading = time_ms([&]() {
+        mapped_lts<finite_ccs, std::pair<bool,std::string>> mapped(directory / "cott_bench.lts");
+        edges = 0;
+        for (std::uint32_t s = 0; s<mapped.state_count(); s++)
+            edges += mapped.successors(s).size();
+    }, 3);
+    std::cout << "visit streaming .aut and DOT: " << streaming << " ms, binary LTS saved in " << saving
+              << " ms, mapped with " << edges << " edges scanned in " << loading << " ms ("
+              << std::filesystem::file_size(directory / "cott_bench.lts") << " bytes)" << std::endl;
+    std::filesystem::remove_all(directory);
+}
+
+static void query(const char* name, const std::shared_ptr<finite_ccs>& process, bool deadlock) {
+    small_step_semantics<finite_ccs, std::pair<bool,std::string>, interned_keys<finite_ccs>> semantics;
+    add_finite_ccs_rules(semantics);
+    semantics.set_discriminator(finite_ccs_discriminator);
+    auto answer = deadlock ? semantics.find_deadlock(process) : semantics.find_reachable(process, [](const std::shared_ptr<finite_ccs>& t) {
+        // Reaching a state where the first process has terminated
+        return (t->casus == ParallelComposition) && (t->parallel_compose.front()->casus == NIL);
+    });
+    std::cout << name << ": " << (answer.found() ? "found" : "not found") << " after " << answer.exploration.states
+              << " states in " << answer.exploration.elapsed_ms << " ms";
+    if (answer.found())
+        std::cout << ", witness of length " << answer.witness->length();
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 6;
+    size_t depth = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 3;
+    auto process = interleaved_processes(n, depth);
+    explore<structural_keys<finite_ccs>>("structural", process);
+    explore<interned_keys<finite_ccs>>("interned", process);
+    explore<structural_keys<finite_ccs>>("structural, arena", process, true);
+    explore<interned_keys<finite_ccs>>("interned, arena", process, true);
+    explore_compact<structural_keys<finite_ccs>>("structural, compact", process);
+    explore_compact<interned_keys<finite_ccs>>("interned, compact", process);
+
+    exploration_options options;
+    options.strategy = exploration_strategy::breadth_first;
+    explore_with("breadth-first", process, options);
+    options.strategy = exploration_strategy::iterative_deepening;
+    explore_with("iterative deepening", process, options);
+    options.strategy = exploration_strategy::depth_bounded;
+    options.max_depth = n * depth / 2;
+    explore_with("depth-bounded to half the depth", process, options);
+    options = {};
+    options.max_states = 1000;
+    explore_with("depth-first, at most 1000 states", process, options);
+    options = {};
+    options.max_memory = 1 << 20;
+    explore_with("depth-first, at most 1 MiB", process, options);
+    explore_external("breadth-first, on disk", process);
+    explore_compressed(process);
+    explore_bitstate("bitstate, 64 KiB", process, 1 << 16);
+    explore_bitstate("bitstate, 1 KiB", process, 1 << 10);
+    checkpoint_and_resume(process);
+    export_and_reload(process);
+
+    explore_reduced("full interleaving", process, false);
+    explore_reduced("partial-order reduced", process, true);
+    explore_symmetric("replicated processes", replicated_processes(n, depth), false);
+    explore_symmetric("replicated processes, canonical forms", replicated_processes(n, depth), true);
+
+    query("reachability of a terminated first process", process, false);
+    query("deadlock", process, true);
+    query("deadlock under restriction", std::make_shared<finite_ccs>(std::vector<std::string>{"a0_0"}, process), true);
+    return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ * workloads.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Scalable workloads for the benchmarks, over the two examples
+ */
+
+#ifndef COTT_BENCHMARKS_WORKLOADS_H
+#define COTT_BENCHMARKS_WORKLOADS_H
+
+#include "../examples/uint_arithmetics.h"
+#include "../examples/finite_ccs.h"
+#include <chrono>
+#include <random>
+
+/**
+ * Generating a random expression of the given size, where divisions and subtractions are always well-defined
+ * as their right operand is always one
+ */
+inline std::shared_ptr<num_op> random_num_op(std::mt19937_64& gen, size_t size) {
+    if (size <= 1)
+        return std::make_shared<num_op>(gen() % 10);
+    size_t left = 1 + gen() % (size - 1);
+    switch (gen() % 5) {
+        case 0:
+            return std::make_shared<num_op>(random_num_op(gen, size - 1));
+        case 1:
+            return std::make_shared<num_op>(random_num_op(gen, left), DIV, std::make_shared<num_op>(1));
+        case 2:
+            return std::make_shared<num_op>(random_num_op(gen, left), TIMES, random_num_op(gen, size - left));
+        default:
+            return std::make_shared<num_op>(random_num_op(gen, left), PLUS, random_num_op(gen, size - left));
+    }
+}
+
+/**
+ * Generating a random expression of exactly the given number of nodes, with the same operators as random_num_op
+ */
+inline std::shared_ptr<num_op> random_expression(std::mt19937_64& gen, size_t nodes) {
+    if (nodes <= 1)
+        return std::make_shared<num_op>(gen() % 10);
+    size_t kind = (nodes == 2) ? 0 : gen() % 5;
+    switch (kind) {
+        case 0:
+            return std::make_shared<num_op>(random_expression(gen, nodes - 1));
+        case 1:
+            return std::make_shared<num_op>(random_expression(gen, nodes - 2), DIV, std::make_shared<num_op>(1));
+        default: {
+            size_t left = 1 + gen() % (nodes - 2);
+            return std::make_shared<num_op>(random_expression(gen, left), (kind == 2) ? TIMES : PLUS,
+                                            random_expression(gen, nodes - 1 - left));
+        }
+    }
+}
+
+/**
+ * Generating (((1 + 1) + 1) + ...) + 1 with the given number of additions
+ */
+inline std::shared_ptr<num_op> left_deep_sum(size_t n) {
+    auto one = std::make_shared<num_op>(1);
+    auto result = one;
+    for (size_t i = 0; i<n; i++)
+        result = std::make_shared<num_op>(result, PLUS, one);
+    return result;
+}
+
+/**
+ * Releasing a left-deep expression iteratively, as its recursive destruction would exhaust the stack as well
+ */
+inline void release(std::shared_ptr<num_op> t) {
+    while (t && t.use_count() == 1) {
+        auto next = std::move(t->left);
+        t = std::move(next);
+    }
+}
+
+/**
+ * Generating a.0 | (b.0 | ...), where each process performs a sequence of depth actions
+ */
+inline std::shared_ptr<finite_ccs> interleaved_processes(size_t n, size_t depth) {
+    std::shared_ptr<finite_ccs> result;
+    for (size_t i = 0; i<n; i++) {
+        auto process = std::make_shared<finite_ccs>();
+        for (size_t j = 0; j<depth; j++) {
+            std::pair<bool,std::string> label{false, "a" + std::to_string(i) + "_" + std::to_string(j)};
+            process = std::make_shared<finite_ccs>(std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>>{{label, process}});
+        }
+        result = result ? std::make_shared<finite_ccs>(std::vector<std::shared_ptr<finite_ccs>>{process, result}) : process;
+    }
+    return result;
+}
+
+/**
+ * Generating n copies of a.a. ... .0 in parallel, each performing depth actions a. As the copies are interchangeable,
+ * the (depth+1)^n states collapse under strong bisimulation to the n*depth+1 ones counting the actions performed
+ */
+inline std::shared_ptr<finite_ccs> replicated_processes(size_t n, size_t depth) {
+    std::pair<bool,std::string> a{false, "a"};
+    auto process = std::make_shared<finite_ccs>();
+    for (size_t j = 0; j<depth; j++)
+        process = std::make_shared<finite_ccs>(std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>>{{a, process}});
+    auto result = process;
+    for (size_t i = 1; i<n; i++)
+        result = std::make_shared<finite_ccs>(std::vector<std::shared_ptr<finite_ccs>>{process, result});
+    return result;
+}
+
+/**
+ * Generating n copies of (c'.a.c'.a. ... .0 | c.c. ... .0) \ {c} in parallel, where each copy performs depth actions
+ * a, each preceded by an internal handshake over c. Under branching and weak bisimulation, each copy behaves as
+ * a.a. ... .0
+ */
+inline std::shared_ptr<finite_ccs> handshaking_processes(size_t n, size_t depth) {
+    using prefix = std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>>;
+    std::pair<bool,std::string> a{false, "a"}, send{true, "c"}, receive{false, "c"};
+    auto sender = std::make_shared<finite_ccs>(), receiver = std::make_shared<finite_ccs>();
+    for (size_t j = 0; j<depth; j++) {
+        sender = std::make_shared<finite_ccs>(prefix{{send, std::make_shared<finite_ccs>(prefix{{a, sender}})}});
+        receiver = std::make_shared<finite_ccs>(prefix{{receive, receiver}});
+    }
+    auto process = std::make_shared<finite_ccs>(std::vector<std::string>{"c"},
+                                                std::make_shared<finite_ccs>(std::vector<std::shared_ptr<finite_ccs>>{sender, receiver}));
+    auto result = process;
+    for (size_t i = 1; i<n; i++)
+        result = std::make_shared<finite_ccs>(std::vector<std::shared_ptr<finite_ccs>>{process, result});
+    return result;
+}
+
+/**
+ * Generating n dining philosophers around n forks, where each philosopher eats rounds times by taking its left fork,
+ * then its right one, and releasing both. The forks are processes offering to be taken and released by either of
+ * their neighbours, and all the handshakes are restricted, so that only the eat actions are visible. The system
+ * deadlocks when every philosopher holds its left fork.
+ */
+inline std::shared_ptr<finite_ccs> dining_philosophers(size_t n, size_t rounds) {
+    using prefix = std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>>;
+    auto channel = [](const char* name, size_t fork, size_t philosopher) {
+        return name + std::to_string(fork) + "_" + std::to_string(philosopher);
+    };
+    std::vector<std::shared_ptr<finite_ccs>> components;
+    std::vector<std::string> restricted;
+    for (size_t p = 0; p<n; p++) {
+        size_t left = p, right = (p + 1) % n;
+        auto philosopher = std::make_shared<finite_ccs>();
+        for (size_t r = 0; r<rounds; r++) {
+            philosopher = std::make_shared<finite_ccs>(prefix{{{true, channel("put", right, p)}, philosopher}});
+            philosopher = std::make_shared<finite_ccs>(prefix{{{true, channel("put", left, p)}, philosopher}});
+            philosopher = std::make_shared<finite_ccs>(prefix{{{false, "eat" + std::to_string(p)}, philosopher}});
+            philosopher = std::make_shared<finite_ccs>(prefix{{{true, channel("get", right, p)}, philosopher}});
+            philosopher = std::make_shared<finite_ccs>(prefix{{{true, channel("get", left, p)}, philosopher}});
+        }
+        components.emplace_back(philosopher);
+    }
+    for (size_t f = 0; f<n; f++) {
+        // Either neighbour can take the fork, which is used 2*rounds times overall
+        size_t first = f, second = (f + n - 1) % n;
+        auto fork = std::make_shared<finite_ccs>();
+        for (size_t uses = 0; uses < 2 * rounds; uses++) {
+            prefix choice;
+            for (size_t p : {first, second}) {
+                auto release = std::make_shared<finite_ccs>(prefix{{{false, channel("put", f, p)}, fork}});
+                choice.push_back({{false, channel("get", f, p)}, release});
+                for (const char* name : {"get", "put"})
+                    restricted.emplace_back(channel(name, f, p));
+            }
+            fork = std::make_shared<finite_ccs>(choice);
+        }
+        components.emplace_back(fork);
+    }
+    std::sort(restricted.begin(), restricted.end());
+    restricted.erase(std::unique(restricted.begin(), restricted.end()), restricted.end());
+    return std::make_shared<finite_ccs>(restricted, std::make_shared<finite_ccs>(components));
+}
+
+/**
+ * Generating a ring of n stations passing a token rounds times around: each station waits for the token, enters its
+ * critical section, passes the token to the next one, and then performs a local action, concurrently with the others.
+ * The token passing is restricted, and the first station starts with the token, which it gets back after each round
+ */
+inline std::shared_ptr<finite_ccs> token_ring(size_t n, size_t rounds) {
+    using prefix = std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>>;
+    auto action = [](const char* name, size_t i) { return name + std::to_string(i); };
+    std::vector<std::shared_ptr<finite_ccs>> stations;
+    std::vector<std::string> restricted;
+    for (size_t i = 0; i<n; i++) {
+        auto station = std::make_shared<finite_ccs>();
+        for (size_t r = 0; r<rounds; r++) {
+            // The first station gets the token back at the end of each round, rather than at its beginning
+            if (i == 0)
+                station = std::make_shared<finite_ccs>(prefix{{{false, action("token", i)}, station}});
+            station = std::make_shared<finite_ccs>(prefix{{{false, action("local", i)}, station}});
+            station = std::make_shared<finite_ccs>(prefix{{{true, action("token", (i + 1) % n)}, station}});
+            station = std::make_shared<finite_ccs>(prefix{{{false, action("critical", i)}, station}});
+            if (i > 0)
+                station = std::make_shared<finite_ccs>(prefix{{{false, action("token", i)}, station}});
+        }
+        stations.emplace_back(station);
+        restricted.emplace_back(action("token", i));
+    }
+    return std::make_shared<finite_ccs>(restricted, std::make_shared<finite_ccs>(stations));
+}
+
+/**
+ * Generating n senders and n receivers, composed in parallel and restricted over the channel c they share, where each
+ * sender performs depth outputs c', and each receiver depth inputs c, so that any sender can synchronise with any
+ * receiver
+ */
+inline std::shared_ptr<finite_ccs> synchronising_processes(size_t n, size_t depth) {
+    using prefix = std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>>;
+    auto sender = std::make_shared<finite_ccs>(), receiver = std::make_shared<finite_ccs>();
+    for (size_t j = 0; j<depth; j++) {
+        sender = std::make_shared<finite_ccs>(prefix{{{true, "c"}, sender}});
+        receiver = std::make_shared<finite_ccs>(prefix{{{false, "c"}, receiver}});
+    }
+    std::vector<std::shared_ptr<finite_ccs>> components;
+    for (size_t i = 0; i<n; i++) {
+        components.emplace_back(sender);
+        components.emplace_back(receiver);
+    }
+    return std::make_shared<finite_ccs>(std::vector<std::string>{"c"}, std::make_shared<finite_ccs>(components));
+}
+
+/**
+ * Best wall-clock time out of few repetitions, in milliseconds
+ */
+template <typename F>
+inline double time_ms(F&& f, size_t repetitions = 5) {
+    double best = std::numeric_limits<double>::max();
+    for (size_t i = 0; i<repetitions; i++) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(end - start).count());
+    }
+    return best;
+}
+
+#endif //COTT_BENCHMARKS_WORKLOADS_H
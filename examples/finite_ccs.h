@@ -0,0 +1,398 @@
+/*
+ * finite_ccs.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COTT_EXAMPLES_FINITE_CCS_H
+#define COTT_EXAMPLES_FINITE_CCS_H
+
+#include <operational_semantics/small_step_semantics.h>
+#include <operational_semantics/canonical_form.h>
+#include <operational_semantics/is_serializable.h>
+#include <operational_semantics/hash_combine.h>
+#include <operational_semantics/structural_equality.h>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <set>
+
+/**
+ * Defining all the inductive cases for finite CCS
+ */
+enum finite_ccs_process_cases {
+    NIL = 0,
+    MultiPrefix,
+    ParallelComposition,
+    Restriction
+};
+
+/**
+ * Structure for englobing all the inductive cases
+ */
+struct finite_ccs {
+    finite_ccs_process_cases casus;
+    std::vector<std::string> restr_label;
+    std::vector<std::shared_ptr<finite_ccs>> parallel_compose;
+    std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>> multi_prefix;
+    cached_hash hash_cache;     ///< Set by the first std::hash of the process, which shall not be modified afterwards
+
+    finite_ccs() : casus{NIL} {}
+    finite_ccs(const finite_ccs& ) = default;
+    finite_ccs(finite_ccs&& ) = default;
+    finite_ccs& operator=(const finite_ccs& ) = default;
+    finite_ccs& operator=(finite_ccs&& ) = default;
+    finite_ccs(std::vector<std::shared_ptr<finite_ccs>> v) : casus{ParallelComposition}, parallel_compose(std::move(v)) {
+
+    }
+
+    finite_ccs(std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>> ls) : casus{MultiPrefix} {
+        multi_prefix.insert(multi_prefix.begin(), ls.begin(), ls.end());
+    }
+
+    finite_ccs(const std::vector<std::string>& label, std::shared_ptr<finite_ccs> lhs) : casus{Restriction}, restr_label{label} {
+        parallel_compose.emplace_back(std::move(lhs));
+    }
+
+    bool operator==(const finite_ccs &rhs) const;
+
+    bool operator!=(const finite_ccs &rhs) const {
+        return !(rhs == *this);
+    }
+
+
+};
+
+namespace std {
+    // Making vector of strings hashable, depending on the order of the strings, as their equality does
+    template <> struct hash<std::vector<std::string>> {
+        size_t operator()(const std::vector<std::string>& v) const {
+            return hash_range(v.begin(), v.end(), v.size());
+        }
+    };
+
+    // Making pairs hashable
+    template <typename K, typename V> struct hash<std::pair<K, V>> {
+        size_t operator()(const std::pair<K, V>& v) const {
+            return hash_values(v.first, v.second);
+        }
+    };
+
+    // Making ccs formulae hashable, where the hash is cached by the process
+    template <> struct hash<finite_ccs> {
+        size_t operator()(const finite_ccs& x) const {
+            return x.hash_cache.get([this, &x]() { return structural(x); });
+        }
+
+    private:
+        size_t structural(const finite_ccs& x) const {
+            switch (x.casus) {
+                case NIL:
+                    return hash_mix(NIL);
+                case MultiPrefix: {
+                    // The choice is compared as a set of prefixes, which is thus hashed regardless of their order and repetitions
+                    set_hash prefixes{MultiPrefix};
+                    for (const auto& [k, v] : x.multi_prefix)
+                        prefixes.add(hash_combine(std::hash<std::pair<bool,std::string>>()(k), operator()(*v)));
+                    return prefixes.value();
+                }
+                case ParallelComposition: {
+                    ordered_hash components{ParallelComposition};
+                    for (const auto& child : x.parallel_compose)
+                        components.add(operator()(*child));
+                    return components.value();
+                }
+                case Restriction:
+                    return ordered_hash{Restriction}.add_value(x.restr_label).add(operator()(*x.parallel_compose[0])).value();
+            }
+            return 0;
+        }
+    };
+}
+
+/**
+ * Implementing CCS structural equality
+ * @param rhs
+ * @return
+ */
+inline bool finite_ccs::operator==(const finite_ccs &rhs) const {
+    KeyEqualizer<finite_ccs> ke;
+    if (casus != rhs.casus)
+        return false;
+    switch (casus) {
+        case NIL:
+            return true;
+        case MultiPrefix:
+            // The choice is a set of prefixes, whose continuations are compared by structure
+            return unordered_set_equal(multi_prefix.begin(), multi_prefix.end(), rhs.multi_prefix.begin(), rhs.multi_prefix.end(),
+                                       [&ke](const auto& l, const auto& r) { return (l.first == r.first) && ke(l.second, r.second); });
+        case ParallelComposition: {
+            if (parallel_compose.size() != rhs.parallel_compose.size())
+                return false;
+            for (size_t i = 0, N = parallel_compose.size(); i<N; i++)
+                if (!(ke(parallel_compose[i], rhs.parallel_compose[i])))
+                    return false;
+            return true;
+        }
+        case Restriction: {
+            if (restr_label != rhs.restr_label)
+                return false;
+            return (ke(parallel_compose[0], rhs.parallel_compose[0]));
+        }
+    }
+    return false;
+}
+
+/**
+ * Hash-consing finite CCS processes: the children are interned first, so that hashing and comparing a process only
+ * has to look at its own labels and at the children's canonical pointers
+ */
+template <> struct interning_traits<finite_ccs> {
+    template <typename F>
+    static void for_each_child(finite_ccs& x, F&& f) {
+        for (auto& child : x.parallel_compose)
+            f(child);
+        for (auto& [label, child] : x.multi_prefix)
+            f(child);
+    }
+
+    static std::size_t shallow_hash(const finite_ccs& x, const term_interner<finite_ccs>& interner) {
+        switch (x.casus) {
+            case NIL:
+                return hash_mix(NIL);
+            case MultiPrefix: {
+                // Only the distinct prefixes are hashed, as duplicates are equivalent
+                set_hash prefixes{MultiPrefix};
+                for (const auto& [k, v] : x.multi_prefix)
+                    prefixes.add(hash_combine(std::hash<std::pair<bool,std::string>>()(k), interner.hash(v)));
+                return prefixes.value();
+            }
+            case ParallelComposition: {
+                ordered_hash components{ParallelComposition};
+                for (const auto& child : x.parallel_compose)
+                    components.add(interner.hash(child));
+                return components.value();
+            }
+            case Restriction:
+                return ordered_hash{Restriction}.add_value(x.restr_label).add(interner.hash(x.parallel_compose[0])).value();
+        }
+        return 0;
+    }
+
+    static bool shallow_equal(const finite_ccs& lhs, const finite_ccs& rhs) {
+        if (lhs.casus != rhs.casus)
+            return false;
+        switch (lhs.casus) {
+            case NIL:
+                return true;
+            case MultiPrefix:
+                return unordered_set_equal(lhs.multi_prefix.begin(), lhs.multi_prefix.end(), rhs.multi_prefix.begin(), rhs.multi_prefix.end(),
+                                           [](const auto& l, const auto& r) { return (l.first == r.first) && (l.second == r.second); });
+            case ParallelComposition:
+                return lhs.parallel_compose == rhs.parallel_compose;
+            case Restriction:
+                return (lhs.restr_label == rhs.restr_label) && (lhs.parallel_compose == rhs.parallel_compose);
+        }
+        return false;
+    }
+};
+
+/**
+ * Parallel composition is associative and commutative: the canonical form of a process flattens its nested parallel
+ * compositions into a single one, whose components are sorted
+ */
+template <> struct canonical_form_traits<finite_ccs> {
+    template <typename F>
+    static void for_each_child(finite_ccs& x, F&& f) {
+        interning_traits<finite_ccs>::for_each_child(x, std::forward<F>(f));
+    }
+
+    static std::vector<std::shared_ptr<finite_ccs>>* operands(finite_ccs& x) {
+        return (x.casus == ParallelComposition) ? &x.parallel_compose : nullptr;
+    }
+
+    static bool same_constructor(const finite_ccs&, const finite_ccs& operand) {
+        return operand.casus == ParallelComposition;
+    }
+};
+
+/**
+ * Serializing a process as its inductive case, followed by the fields it uses
+ */
+template <> struct serialization_traits<finite_ccs> {
+    static void write(const finite_ccs& x, std::string& out) {
+        serialization_traits<finite_ccs_process_cases>::write(x.casus, out);
+        switch (x.casus) {
+            case NIL:
+                break;
+            case MultiPrefix:
+                serialization_traits<decltype(x.multi_prefix)>::write(x.multi_prefix, out);
+                break;
+            case Restriction:
+                serialization_traits<std::vector<std::string>>::write(x.restr_label, out);
+                [[fallthrough]];
+            case ParallelComposition:
+                serialization_traits<decltype(x.parallel_compose)>::write(x.parallel_compose, out);
+                break;
+        }
+    }
+
+    static finite_ccs read(const char*& in) {
+        finite_ccs x;
+        x.casus = serialization_traits<finite_ccs_process_cases>::read(in);
+        switch (x.casus) {
+            case NIL:
+                break;
+            case MultiPrefix:
+                x.multi_prefix = serialization_traits<decltype(x.multi_prefix)>::read(in);
+                break;
+            case Restriction:
+                x.restr_label = serialization_traits<std::vector<std::string>>::read(in);
+                [[fallthrough]];
+            case ParallelComposition:
+                x.parallel_compose = serialization_traits<decltype(x.parallel_compose)>::read(in);
+                break;
+        }
+        return x;
+    }
+};
+
+/**
+ * Discriminator for the indexed dispatch: the inductive case of the process, while the null pointer is mapped
+ * to a key never used by any rule
+ */
+inline std::size_t finite_ccs_discriminator(const std::shared_ptr<finite_ccs>& op) {
+    return op ? (std::size_t)op->casus : std::numeric_limits<std::size_t>::max();
+}
+
+/**
+ * Collecting the sequential components of a process, by descending through its parallel compositions and
+ * restrictions, alongside whether each of them differs in the successor, where the structure above the components is
+ * preserved and the unchanged components are shared
+ */
+inline void finite_ccs_components(const std::shared_ptr<finite_ccs>& src, const std::shared_ptr<finite_ccs>& dst,
+                                  std::vector<std::pair<const finite_ccs*, bool>>& components) {
+    if ((src->casus == dst->casus) && ((src->casus == ParallelComposition) || (src->casus == Restriction)) &&
+        (src->parallel_compose.size() == dst->parallel_compose.size())) {
+        for (size_t i = 0, N = src->parallel_compose.size(); i<N; i++)
+            finite_ccs_components(src->parallel_compose[i], dst->parallel_compose[i], components);
+        return;
+    }
+    components.emplace_back(src.get(), (src != dst) && !(*src == *dst));
+}
+
+/**
+ * Channels over which a process might ever act, alongside their polarity, ignoring the restrictions
+ */
+inline void finite_ccs_channels(const finite_ccs& x, std::set<std::pair<bool,std::string>>& channels) {
+    for (const auto& [label, child] : x.multi_prefix) {
+        if (label.second != ".")
+            channels.insert(label);
+        finite_ccs_channels(*child, channels);
+    }
+    for (const auto& child : x.parallel_compose)
+        finite_ccs_channels(*child, channels);
+}
+
+/**
+ * Independence relation for the partial-order reduction: two transitions are independent if they move disjoint
+ * sequential components, and the ones moved by either transition can never synchronise with the other components
+ */
+inline bool finite_ccs_independent(const std::shared_ptr<finite_ccs>& state,
+                                   const std::pair<bool,std::string>&, const std::shared_ptr<finite_ccs>& t,
+                                   const std::pair<bool,std::string>&, const std::shared_ptr<finite_ccs>& u) {
+    std::vector<std::pair<const finite_ccs*, bool>> moved_t, moved_u;
+    finite_ccs_components(state, t, moved_t);
+    finite_ccs_components(state, u, moved_u);
+    if (moved_t.size() != moved_u.size())
+        return false;
+    for (size_t i = 0; i<moved_t.size(); i++)
+        if (moved_t[i].second && moved_u[i].second)
+            return false;
+    // Whether the components moved by a transition are isolated from the others
+    auto isolated = [](const std::vector<std::pair<const finite_ccs*, bool>>& moved) {
+        std::set<std::pair<bool,std::string>> inside, outside;
+        for (const auto& [component, changed] : moved)
+            finite_ccs_channels(*component, changed ? inside : outside);
+        for (const auto& [polarity, name] : inside)
+            if (outside.contains({!polarity, name}))
+                return false;
+        return true;
+    };
+    return isolated(moved_t) || isolated(moved_u);
+}
+
+/**
+ * Registering the finite CCS small-step semantics, where each rule is keyed by the process' inductive case.
+ * @param finiteCCS_graph_Semantics     Semantics to be filled in
+ */
+inline void add_finite_ccs_rules(language_semantics<finite_ccs, std::pair<bool,std::string>, finite_ccs>& finiteCCS_graph_Semantics) {
+    std::string tau = ".";
+    std::pair<bool,std::string> tauPair{false, tau};
+
+    // MultiPrefix rule: reducing the expression to the others to be returned
+    finiteCCS_graph_Semantics.add_emitting_rule(MultiPrefix, [](const std::shared_ptr<finite_ccs>& op) {
+        return (op) && op->casus == MultiPrefix && (!op->multi_prefix.empty());
+    }, [](language_semantics<finite_ccs, std::pair<bool,std::string>, finite_ccs>* rec, const std::shared_ptr<finite_ccs>& op, successor_sink<std::pair<bool,std::string>, finite_ccs> out) {
+        for (const auto& [key, val] : op->multi_prefix)
+            out(key, val);
+    });
+
+    // Parallel Composition rule, for which we expand only one of the arguments at a time, and output the resulting transitions.
+    // The visible actions are also retained, so to synchronise the complementary ones performed by different arguments
+    finiteCCS_graph_Semantics.add_emitting_rule(ParallelComposition, [](const std::shared_ptr<finite_ccs>& op) {
+        return (op) && op->casus == ParallelComposition && (!op->parallel_compose.empty());
+    }, [tau,tauPair](language_semantics<finite_ccs, std::pair<bool,std::string>, finite_ccs>* rec, const std::shared_ptr<finite_ccs>& op, successor_sink<std::pair<bool,std::string>, finite_ccs> out) {
+        std::vector<std::tuple<size_t, std::pair<bool,std::string>, std::shared_ptr<finite_ccs>>> visible;
+        for (size_t i = 0, N = op->parallel_compose.size(); i<N; i++) {
+            rec->emit(op->parallel_compose[i], [&](const std::pair<bool,std::string>& key, const std::shared_ptr<finite_ccs>& val) {
+                if (key.second != tau)
+                    visible.emplace_back(i, key, val);
+                auto current = make_term<finite_ccs>(*op);
+                current->parallel_compose[i] = val;
+                out(key, current);
+            });
+        }
+        for (const auto& [i, key_i, val_i] : visible) {
+            if (!key_i.first) continue;
+            for (const auto& [j, key_j, val_j] : visible) {
+                if ((!key_j.first) && (i != j) && (key_i.second == key_j.second)) {
+                    auto current = make_term<finite_ccs>(*op);
+                    current->parallel_compose[i] = val_i;
+                    current->parallel_compose[j] = val_j;
+                    out(tauPair, current);
+                }
+            }
+        }
+    });
+
+    // Restriction: removing as viable transitions all the ones that appear within the set of forbidden rules.
+    // This is to force synchronisation between processes sharing the same signed-unsigned elements
+    finiteCCS_graph_Semantics.add_emitting_rule(Restriction, [](const std::shared_ptr<finite_ccs>& op) {
+        return (op) && op->casus == Restriction && (op->parallel_compose.size() == 1) && (!op->restr_label.empty());
+    }, [](language_semantics<finite_ccs, std::pair<bool,std::string>, finite_ccs>* rec, const std::shared_ptr<finite_ccs>& op, successor_sink<std::pair<bool,std::string>, finite_ccs> out) {
+        rec->emit(op->parallel_compose[0], [&](const std::pair<bool,std::string>& key, const std::shared_ptr<finite_ccs>& val) {
+            if (std::find(op->restr_label.begin(), op->restr_label.end(), key.second) != op->restr_label.end())
+                return;
+            auto current = make_term<finite_ccs>(*op);
+            current->parallel_compose[0] = val;
+            out(key, current);
+        });
+    });
+}
+
+#endif //COTT_EXAMPLES_FINITE_CCS_H
@@ -0,0 +1,250 @@
+/*
+ * uint_arithmetics.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COTT_EXAMPLES_UINT_ARITHMETICS_H
+#define COTT_EXAMPLES_UINT_ARITHMETICS_H
+
+#include <operational_semantics.h>
+#include <limits>
+
+/**
+ * Defining all the inductive cases for uint expressions
+ */
+enum op_type {
+    PLUS,
+    MINUS,
+    DIV,
+    TIMES,
+    VAL,
+    EXPR
+};
+
+struct num_op {
+    size_t val{0}; // Base case value
+    std::shared_ptr<num_op> left, right; // Operands
+    op_type casus; // Inductive case
+
+    /**
+     * Expression printing
+     * @param os    Stream
+     * @param op    Expression
+     * @return
+     */
+    friend std::ostream &operator<<(std::ostream &os, const num_op &op) {
+        switch (op.casus) {
+            case EXPR:
+                return os << "(" << *op.left << ")";
+            case VAL:
+                return os << op.val;
+            case PLUS:
+                return os <<"(" << *op.left << ") + (" << *op.right << ")";
+            case MINUS:
+                return os <<"(" << *op.left << ") - (" << *op.right << ")";
+            case TIMES:
+                return os <<"(" << *op.left << ") * (" << *op.right << ")";
+            case DIV:
+                return os <<"(" << *op.left << ") / (" << *op.right << ")";
+        }
+        return os;
+    }
+
+    /**
+     * Creating a base case number
+     * @param val   Number
+     */
+    num_op(size_t val) : val{val}, left{nullptr}, right{nullptr}, casus{VAL} {}
+
+    /**
+     * Mimicking the (...) for an expression
+     * @param arg   Expression
+     */
+    num_op(std::shared_ptr<num_op> arg) : left{std::move(arg)},
+                                          right{nullptr},
+                                          casus{EXPR} {}
+
+    /**
+     * Constructor for any binary numeric operator
+     * @param left      Left operand
+     * @param op        Opeator
+     * @param right     Right operand
+     */
+    num_op(std::shared_ptr<num_op> left,
+           op_type op,
+           std::shared_ptr<num_op> right) : left{std::move(left)},
+                                            right{std::move(right)},
+                                            casus{op} {}
+
+    /**
+     * Checking whether the two expressions are syntactically equivalent
+     * @param rhs
+     * @return
+     */
+    bool operator==(const num_op &rhs) const {
+        return casus == rhs.casus && val == rhs.val &&
+               (((bool)left) == ((bool)rhs.left)) && ((!left) || (*left == *rhs.left)) &&
+               (((bool)right) == ((bool)rhs.right)) && ((!right) || (*right == *rhs.right));
+    }
+
+    /**
+     * Syntactic inequivalence
+     * @param rhs
+     * @return
+     */
+    bool operator!=(const num_op &rhs) const {
+        return !(rhs == *this);
+    }
+};
+
+namespace std {
+    /**
+     * Expression hashability, depending on the position of the operands, so that mirrored expressions do not collide
+     */
+    template <> struct hash<num_op> {
+        size_t operator()(const struct num_op& x) const {
+            size_t lh = (x.left) ? operator()(*x.left) *2+1 : 0;
+            size_t rh = (x.right) ? operator()(*x.right) *2+1 : 0;
+            return ordered_hash{(size_t)x.casus}.add(x.val).add(lh).add(rh).value();
+        }
+    };
+}
+
+/**
+ * Discriminator for the indexed dispatch: the inductive case of the expression, while the null pointer is mapped
+ * to a key never used by any rule, thus only testing the rules registered without a key
+ */
+inline std::size_t num_op_discriminator(const std::shared_ptr<num_op>& arg) {
+    return arg ? (std::size_t)arg->casus : std::numeric_limits<std::size_t>::max();
+}
+
+/*
+ * The rules of the natural numbers arithmetics semantics. As their recursion pointer is generic, the very same rules
+ * can be either registered to a language_semantics (see add_uint_arithmetics_rules), or fixed at compile time into a
+ * static_language_semantics (see make_static_uint_arithmetics)
+ */
+
+// None rule: is the argument is a null pointer, interpreting this as a zero number
+inline const auto uint_none_rule = static_rule{[](const std::shared_ptr<num_op>& arg) {
+    return (!arg);
+}, [](auto* rec, const std::shared_ptr<num_op>& arg) {
+    std::vector<std::pair<std::string,std::shared_ptr<size_t>>> result;
+    result.emplace_back("none", make_term<size_t>(0));
+    return result;
+}};
+
+// Base case: if the value is a number, returning this as its semantics
+inline const auto uint_val_rule = static_rule{[](const std::shared_ptr<num_op>& arg) {
+    return (arg) && arg->casus == VAL;
+}, [](auto* rec, const std::shared_ptr<num_op>& arg) {
+    std::vector<std::pair<std::string,std::shared_ptr<size_t>>> result;
+    result.emplace_back("val", make_term<size_t>(arg->val));
+    return result;
+}};
+
+// Generic expression: if this is a parenthesis, then return the evaluation of the enclosed expression
+inline const auto uint_expr_rule = static_rule{[](const std::shared_ptr<num_op>& arg) {
+    return (arg) && (arg->left) && arg->casus == EXPR;
+}, [](auto* rec, const std::shared_ptr<num_op>& arg) {
+    return rec->operator()(arg->left);
+}};
+
+// Plus: if the operator is a plus and none of the argument is null, and if the recursive call is still holding by
+// returning a non-empty vector, then considering the first returned output for the computation for each operand
+// and perform the sum of the two intermediate results
+inline const auto uint_plus_rule = static_rule{[](const std::shared_ptr<num_op>& arg) {
+    return (arg) && (arg->left) && (arg->right) && arg->casus == PLUS;
+}, [](auto* rec, const std::shared_ptr<num_op>& arg) {
+    auto L = rec->operator()(arg->left);
+    auto R = rec->operator()(arg->right);
+    std::vector<std::pair<std::string,std::shared_ptr<size_t>>> result;
+    if ((!L.empty()) && (!R.empty())) {
+        size_t op_result = *L[0].second + *R[0].second ;
+        result.emplace_back("PLUS", make_term<size_t>(op_result));
+    }
+    return result;
+}};
+
+// Times: same as above, but for the multiplication
+inline const auto uint_times_rule = static_rule{[](const std::shared_ptr<num_op>& arg) {
+    return (arg) && (arg->left) && (arg->right) && arg->casus == TIMES;
+}, [](auto* rec, const std::shared_ptr<num_op>& arg) {
+    auto L = rec->operator()(arg->left);
+    auto R = rec->operator()(arg->right);
+    std::vector<std::pair<std::string,std::shared_ptr<size_t>>> result;
+    if ((!L.empty()) && (!R.empty())) {
+        size_t op_result = *L[0].second * *R[0].second ;
+        result.emplace_back("TIMES", make_term<size_t>(op_result));
+    }
+    return result;
+}};
+
+// Minus: same as above, but considering tha the left operand shall always be greater or equal to the right one,
+// as we do not allow for negative values. Otherwise, no value is provided
+inline const auto uint_minus_rule = static_rule{[](const std::shared_ptr<num_op>& arg) {
+    return (arg) && (arg->left) && (arg->right) && arg->casus == MINUS;
+}, [](auto* rec, const std::shared_ptr<num_op>& arg) {
+    auto L = rec->operator()(arg->left);
+    auto R = rec->operator()(arg->right);
+    std::vector<std::pair<std::string,std::shared_ptr<size_t>>> result;
+    if ((!L.empty()) && (!R.empty()) && (*L[0].second >= *R[0].second)) {
+        size_t op_result = *L[0].second - *R[0].second ;
+        result.emplace_back("MINUS", make_term<size_t>(op_result));
+    }
+    return result;
+}};
+
+// Division: same as the sum, but considering that the right operand is not evaluated to zero, as we do not allow
+// a division by zero
+inline const auto uint_div_rule = static_rule{[](const std::shared_ptr<num_op>& arg) {
+    return (arg) && (arg->left) && (arg->right) && arg->casus == DIV;
+}, [](auto* rec, const std::shared_ptr<num_op>& arg) {
+    auto L = rec->operator()(arg->left);
+    auto R = rec->operator()(arg->right);
+    std::vector<std::pair<std::string,std::shared_ptr<size_t>>> result;
+    if ((!L.empty()) && (!R.empty()) && (*R[0].second > 0)) {
+        size_t op_result = *L[0].second / *R[0].second ;
+        result.emplace_back("MINUS", make_term<size_t>(op_result));
+    }
+    return result;
+}};
+
+/**
+ * Registering the natural numbers arithmetics semantics. Each rule but the one for the null pointer is keyed
+ * by the expression's inductive case, so that the same rules can be evaluated either by linear scan or by
+ * indexed dispatch via num_op_discriminator
+ * @param transformer   Semantics to be filled in
+ */
+inline void add_uint_arithmetics_rules(language_semantics<num_op, std::string, size_t>& transformer) {
+    transformer.add_rule(uint_none_rule.test, uint_none_rule.transform);
+    transformer.add_rule(VAL, uint_val_rule.test, uint_val_rule.transform);
+    transformer.add_rule(EXPR, uint_expr_rule.test, uint_expr_rule.transform);
+    transformer.add_rule(PLUS, uint_plus_rule.test, uint_plus_rule.transform);
+    transformer.add_rule(TIMES, uint_times_rule.test, uint_times_rule.transform);
+    transformer.add_rule(MINUS, uint_minus_rule.test, uint_minus_rule.transform);
+    transformer.add_rule(DIV, uint_div_rule.test, uint_div_rule.transform);
+}
+
+/**
+ * @return  The natural numbers arithmetics semantics, where the rules are fixed at compile time
+ */
+inline auto make_static_uint_arithmetics() {
+    return make_static_language_semantics<num_op, std::string, size_t>(uint_none_rule, uint_val_rule, uint_expr_rule, uint_plus_rule, uint_times_rule, uint_minus_rule, uint_div_rule);
+}
+
+#endif //COTT_EXAMPLES_UINT_ARITHMETICS_H
@@ -0,0 +1,413 @@
+/*
+ * uint_arithmetics_bytecode.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COTT_EXAMPLES_UINT_ARITHMETICS_BYTECODE_H
+#define COTT_EXAMPLES_UINT_ARITHMETICS_BYTECODE_H
+
+#include "uint_arithmetics.h"
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define COTT_UINT_BYTECODE_AVX2 1
+#endif
+
+/**
+ * Instructions of the register bytecode into which the expressions are compiled
+ */
+enum class uint_opcode : std::uint8_t {
+    CONST,          ///< dst := value
+    INPUT,          ///< dst := the value-th input
+    PLUS,           ///< dst := lhs + rhs, wrapping around
+    MINUS,          ///< dst := lhs - rhs, undefined if lhs < rhs
+    TIMES,          ///< dst := lhs * rhs, wrapping around
+    DIV,            ///< dst := lhs / rhs, undefined if rhs = 0
+    UNDEFINED       ///< The expression is ill-formed (e.g., an operand is missing), as no rule applies to it
+};
+
+struct uint_instruction {
+    uint_opcode op;
+    std::uint32_t dst = 0, lhs = 0, rhs = 0;
+    std::size_t value = 0;
+};
+
+/**
+ * How to evaluate a batch of instances of a program
+ */
+enum class uint_kernel {
+    automatic,      ///< AVX2, if the processor supports it, and scalar otherwise
+    scalar,         ///< Plain loops over the lanes, which the compiler might vectorise on its own
+    avx2
+};
+
+/**
+ * An expression compiled into a register bytecode, whose leaves are either constants or inputs, evaluated with the
+ * same semantics as the rules in uint_arithmetics.h: additions and multiplications wrap around, while a subtraction
+ * of a greater number or a division by zero make the whole expression undefined, as any other ill-formed
+ * subexpression does, as all the rules are strict in their operands. Therefore, a single definedness mask per
+ * instance suffices.
+ *
+ * A batch evaluates the program over many instances at once, differing in their inputs only: the instances are split
+ * into tiles, over which each instruction is executed in turn, so that each instruction is decoded once per tile
+ * and executed over contiguous lanes.
+ */
+struct uint_program {
+    static constexpr std::size_t tile = 256;
+
+    std::vector<uint_instruction> code;
+    std::size_t registers = 1;
+    std::size_t inputs = 0;
+
+    /**
+     * Evaluating a single instance
+     * @param values    Value of each input
+     * @return          The value of the expression, if defined
+     */
+    std::optional<std::size_t> operator()(std::span<const std::size_t> values = {}) const {
+        check_inputs(values.size(), 1);
+        std::vector<std::size_t> r(registers);
+        for (const auto& i : code) {
+            switch (i.op) {
+                case uint_opcode::CONST:
+                    r[i.dst] = i.value;
+                    break;
+                case uint_opcode::INPUT:
+                    r[i.dst] = values[i.value];
+                    break;
+                case uint_opcode::PLUS:
+                    r[i.dst] = r[i.lhs] + r[i.rhs];
+                    break;
+                case uint_opcode::MINUS:
+                    if (r[i.lhs] < r[i.rhs])
+                        return std::nullopt;
+                    r[i.dst] = r[i.lhs] - r[i.rhs];
+                    break;
+                case uint_opcode::TIMES:
+                    r[i.dst] = r[i.lhs] * r[i.rhs];
+                    break;
+                case uint_opcode::DIV:
+                    if (!r[i.rhs])
+                        return std::nullopt;
+                    r[i.dst] = r[i.lhs] / r[i.rhs];
+                    break;
+                case uint_opcode::UNDEFINED:
+                    return std::nullopt;
+            }
+        }
+        return r[0];
+    }
+
+    /**
+     * Evaluating a batch of instances
+     * @param values    Inputs of the instances, input-major: the k-th input of the i-th instance is values[k * count + i]
+     * @param count     Number of instances
+     * @param results   Value of each instance, which is unspecified where undefined
+     * @param defined   Whether the value of each instance is defined
+     */
+    void operator()(std::span<const std::size_t> values, std::size_t count, std::span<std::size_t> results,
+                    std::span<std::uint8_t> defined, uint_kernel kernel = uint_kernel::automatic) const {
+        check_inputs(values.size(), count);
+        if ((results.size() < count) || (defined.size() < count))
+            throw std::invalid_argument("Error: the results should hold all the instances");
+        if (kernel == uint_kernel::automatic)
+            kernel = avx2_supported() ? uint_kernel::avx2 : uint_kernel::scalar;
+        if ((kernel == uint_kernel::avx2) && (!avx2_supported()))
+            throw std::invalid_argument("Error: AVX2 is not supported by this processor");
+        std::vector<std::uint64_t> scratch((registers + 1) * tile);
+        std::vector<const std::uint64_t*> operands(registers);
+        for (std::size_t begin = 0; begin<count; begin += tile) {
+            std::size_t lanes = std::min(tile, count - begin);
+#ifdef COTT_UINT_BYTECODE_AVX2
+            if (kernel == uint_kernel::avx2)
+                run_avx2(values.data(), count, begin, lanes, scratch.data(), operands.data());
+            else
+#endif
+                run_scalar(values.data(), count, begin, lanes, scratch.data(), operands.data());
+            const std::uint64_t* result = operands[0];
+            const std::uint64_t* mask = scratch.data() + registers * tile;
+            for (std::size_t i = 0; i<lanes; i++) {
+                results[begin + i] = result[i];
+                defined[begin + i] = mask[i] != 0;
+            }
+        }
+    }
+
+    static bool avx2_supported() {
+#ifdef COTT_UINT_BYTECODE_AVX2
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+private:
+    static_assert(sizeof(std::size_t) == sizeof(std::uint64_t), "Error: the lanes are 64-bit wide");
+
+    void check_inputs(std::size_t size, std::size_t count) const {
+        if (size < inputs * count)
+            throw std::invalid_argument("Error: missing inputs");
+    }
+
+    /*
+     * Each kernel evaluates the lanes [begin, begin + lanes) of a batch, over a scratch area of one tile per register,
+     * followed by the tile of the definedness masks, where each lane is either all ones or zero. Each register is read
+     * through its operand pointer, which points to its tile, or straight to the inputs it was loaded with, so that
+     * the inputs of a whole tile are not copied
+     */
+
+    /**
+     * Loading the tile of an input into the register dst: only the last tile, which might be partial, is copied, so
+     * that its padding lanes can be read as well
+     */
+    void load_input(const uint_instruction& i, const std::size_t* values, std::size_t count, std::size_t begin,
+                    std::size_t lanes, std::uint64_t* scratch, const std::uint64_t** operands) const {
+        const std::size_t* column = values + i.value * count + begin;
+        if (lanes == tile) {
+            operands[i.dst] = column;
+        } else {
+            std::copy(column, column + lanes, scratch + i.dst * tile);
+            operands[i.dst] = scratch + i.dst * tile;
+        }
+    }
+
+    void run_scalar(const std::size_t* values, std::size_t count, std::size_t begin, std::size_t lanes,
+                    std::uint64_t* scratch, const std::uint64_t** operands) const {
+        std::uint64_t* mask = scratch + registers * tile;
+        std::fill(mask, mask + lanes, ~std::uint64_t(0));
+        for (const auto& i : code) {
+            if (i.op == uint_opcode::INPUT) {
+                load_input(i, values, count, begin, lanes, scratch, operands);
+                continue;
+            }
+            const std::uint64_t* a = operands[i.lhs];
+            const std::uint64_t* b = operands[i.rhs];
+            std::uint64_t* d = scratch + i.dst * tile;
+            operands[i.dst] = d;
+            switch (i.op) {
+                case uint_opcode::CONST:
+                    std::fill(d, d + lanes, i.value);
+                    break;
+                case uint_opcode::INPUT:
+                    break;
+                case uint_opcode::PLUS:
+                    for (std::size_t j = 0; j<lanes; j++)
+                        d[j] = a[j] + b[j];
+                    break;
+                case uint_opcode::MINUS:
+                    for (std::size_t j = 0; j<lanes; j++) {
+                        mask[j] &= -(std::uint64_t)(a[j] >= b[j]);
+                        d[j] = a[j] - b[j];
+                    }
+                    break;
+                case uint_opcode::TIMES:
+                    for (std::size_t j = 0; j<lanes; j++)
+                        d[j] = a[j] * b[j];
+                    break;
+                case uint_opcode::DIV:
+                    for (std::size_t j = 0; j<lanes; j++) {
+                        mask[j] &= -(std::uint64_t)(b[j] != 0);
+                        d[j] = a[j] / (b[j] | (b[j] == 0));
+                    }
+                    break;
+                case uint_opcode::UNDEFINED:
+                    std::fill(mask, mask + lanes, 0);
+                    break;
+            }
+        }
+    }
+
+#ifdef COTT_UINT_BYTECODE_AVX2
+    /**
+     * As run_scalar, four lanes at a time: the padding lanes of the last tile are computed over whatever the scratch
+     * area holds, and then ignored. AVX2 has neither a 64-bit multiplication nor an unsigned comparison, which are
+     * built from the 32-bit multiplications and the signed comparison, while the divisions are still scalar.
+     */
+    __attribute__((target("avx2")))
+    void run_avx2(const std::size_t* values, std::size_t count, std::size_t begin, std::size_t lanes,
+                  std::uint64_t* scratch, const std::uint64_t** operands) const {
+        std::size_t vectors = (lanes + 3) / 4;
+        std::uint64_t* mask = scratch + registers * tile;
+        const __m256i ones = _mm256_set1_epi64x(-1);
+        const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ull);
+        for (std::size_t j = 0; j<vectors; j++)
+            _mm256_storeu_si256((__m256i*)(mask + 4 * j), ones);
+        for (const auto& i : code) {
+            if (i.op == uint_opcode::INPUT) {
+                load_input(i, values, count, begin, lanes, scratch, operands);
+                continue;
+            }
+            const std::uint64_t* a = operands[i.lhs];
+            const std::uint64_t* b = operands[i.rhs];
+            std::uint64_t* d = scratch + i.dst * tile;
+            operands[i.dst] = d;
+            switch (i.op) {
+                case uint_opcode::CONST: {
+                    __m256i x = _mm256_set1_epi64x((long long)i.value);
+                    for (std::size_t j = 0; j<vectors; j++)
+                        _mm256_storeu_si256((__m256i*)(d + 4 * j), x);
+                } break;
+                case uint_opcode::INPUT:
+                    break;
+                case uint_opcode::PLUS:
+                    for (std::size_t j = 0; j<vectors; j++) {
+                        __m256i x = _mm256_loadu_si256((const __m256i*)(a + 4 * j));
+                        __m256i y = _mm256_loadu_si256((const __m256i*)(b + 4 * j));
+                        _mm256_storeu_si256((__m256i*)(d + 4 * j), _mm256_add_epi64(x, y));
+                    }
+                    break;
+                case uint_opcode::MINUS:
+                    for (std::size_t j = 0; j<vectors; j++) {
+                        __m256i x = _mm256_loadu_si256((const __m256i*)(a + 4 * j));
+                        __m256i y = _mm256_loadu_si256((const __m256i*)(b + 4 * j));
+                        // x < y as unsigned, by flipping the signs before the signed comparison
+                        __m256i underflow = _mm256_cmpgt_epi64(_mm256_xor_si256(y, sign), _mm256_xor_si256(x, sign));
+                        __m256i m = _mm256_loadu_si256((const __m256i*)(mask + 4 * j));
+                        _mm256_storeu_si256((__m256i*)(mask + 4 * j), _mm256_andnot_si256(underflow, m));
+                        _mm256_storeu_si256((__m256i*)(d + 4 * j), _mm256_sub_epi64(x, y));
+                    }
+                    break;
+                case uint_opcode::TIMES:
+                    for (std::size_t j = 0; j<vectors; j++) {
+                        __m256i x = _mm256_loadu_si256((const __m256i*)(a + 4 * j));
+                        __m256i y = _mm256_loadu_si256((const __m256i*)(b + 4 * j));
+                        // The low 64 bits of x * y: lo(x) * lo(y) + ((hi(x) * lo(y) + lo(x) * hi(y)) << 32)
+                        __m256i low = _mm256_mul_epu32(x, y);
+                        __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(x, 32), y),
+                                                         _mm256_mul_epu32(x, _mm256_srli_epi64(y, 32)));
+                        _mm256_storeu_si256((__m256i*)(d + 4 * j), _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32)));
+                    }
+                    break;
+                case uint_opcode::DIV:
+                    for (std::size_t j = 0; j<4 * vectors; j++) {
+                        mask[j] &= -(std::uint64_t)(b[j] != 0);
+                        d[j] = a[j] / (b[j] | (b[j] == 0));
+                    }
+                    break;
+                case uint_opcode::UNDEFINED:
+                    std::fill(mask, mask + 4 * vectors, 0);
+                    break;
+            }
+        }
+    }
+#endif
+};
+
+/**
+ * Compiling an expression into a register bytecode, by visiting it without recursion, so that even the deepest
+ * expressions are compiled. The operand needing more registers is evaluated first (Sethi-Ullman), so that the
+ * program uses as many registers as the deepest balanced subexpression, e.g. two for a left- or right-deep one, and the
+ * result is left in the register zero. Shared subexpressions are compiled at each of their occurrences.
+ *
+ * @param t         Expression
+ * @param inputs    Leaves whose value is provided at each evaluation, numbered by their position here, while the other
+ *                  leaves are constants
+ * @return          The compiled expression
+ */
+inline uint_program compile_uint_arithmetics(const std::shared_ptr<num_op>& t,
+                                             const std::vector<std::shared_ptr<num_op>>& inputs = {}) {
+    uint_program program;
+    program.inputs = inputs.size();
+    std::unordered_map<const num_op*, std::size_t> input_index;
+    for (std::size_t k = 0; k<inputs.size(); k++)
+        input_index.try_emplace(inputs[k].get(), k);
+    if (!t) {
+        // As per the rule for the null pointer
+        program.code.push_back({uint_opcode::CONST, 0, 0, 0, 0});
+        return program;
+    }
+    auto binary = [](const num_op* x) {
+        return (x->casus == PLUS) || (x->casus == MINUS) || (x->casus == TIMES) || (x->casus == DIV);
+    };
+
+    // Registers needed by each subexpression, computed in post-order
+    std::unordered_map<const num_op*, std::uint32_t> need;
+    std::vector<std::pair<const num_op*, bool>> pending{{t.get(), false}};
+    while (!pending.empty()) {
+        auto [x, children_done] = pending.back();
+        pending.pop_back();
+        if (need.contains(x))
+            continue;
+        bool complete = (x->casus == EXPR) ? (bool)x->left : ((!binary(x)) || (x->left && x->right));
+        if ((!complete) || ((x->casus != EXPR) && (!binary(x)))) {
+            need.emplace(x, 1);
+        } else if (!children_done) {
+            pending.emplace_back(x, true);
+            pending.emplace_back(x->left.get(), false);
+            if (binary(x))
+                pending.emplace_back(x->right.get(), false);
+        } else if (x->casus == EXPR) {
+            need.emplace(x, need.at(x->left.get()));
+        } else {
+            auto l = need.at(x->left.get()), r = need.at(x->right.get());
+            need.emplace(x, (l == r) ? l + 1 : std::max(l, r));
+        }
+    }
+    program.registers = need.at(t.get());
+
+    // Emitting the code of each subexpression into the given register, after the code of its operands
+    struct frame {
+        const num_op* x;
+        std::uint32_t dst;
+        bool operands_done;
+    };
+    std::vector<frame> frames{{t.get(), 0, false}};
+    bool undefined = false;
+    while ((!frames.empty()) && (!undefined)) {
+        auto [x, dst, operands_done] = frames.back();
+        frames.pop_back();
+        if (x->casus == VAL) {
+            if (auto it = input_index.find(x); it != input_index.end())
+                program.code.push_back({uint_opcode::INPUT, dst, 0, 0, it->second});
+            else
+                program.code.push_back({uint_opcode::CONST, dst, 0, 0, x->val});
+        } else if (x->casus == EXPR) {
+            if (x->left)
+                frames.push_back({x->left.get(), dst, false});
+            else
+                undefined = true;
+        } else if ((!x->left) || (!x->right)) {
+            undefined = true;
+        } else {
+            bool right_first = need.at(x->right.get()) > need.at(x->left.get());
+            std::uint32_t lhs = right_first ? dst + 1 : dst, rhs = right_first ? dst : dst + 1;
+            if (!operands_done) {
+                // The operand evaluated first is pushed last
+                frames.push_back({x, dst, true});
+                frames.push_back({right_first ? x->left.get() : x->right.get(), dst + 1, false});
+                frames.push_back({right_first ? x->right.get() : x->left.get(), dst, false});
+            } else {
+                uint_opcode op = (x->casus == PLUS) ? uint_opcode::PLUS : (x->casus == MINUS) ? uint_opcode::MINUS :
+                                 (x->casus == TIMES) ? uint_opcode::TIMES : uint_opcode::DIV;
+                program.code.push_back({op, dst, lhs, rhs, 0});
+            }
+        }
+    }
+    if (undefined)
+        program.code.assign(1, {uint_opcode::UNDEFINED, 0, 0, 0, 0});
+    return program;
+}
+
+#endif //COTT_EXAMPLES_UINT_ARITHMETICS_BYTECODE_H
@@ -29,7 +29,26 @@
 
 #include <operational_semantics/has_equality.h>
 #include <operational_semantics/is_hashable.h>
+#include <operational_semantics/is_serializable.h>
+#include <operational_semantics/hash_combine.h>
+#include <operational_semantics/structural_equality.h>
+#include <operational_semantics/key_hasher.h>
+#include <operational_semantics/evaluation_cache.h>
+#include <operational_semantics/term_interner.h>
+#include <operational_semantics/term_arena.h>
+#include <operational_semantics/concurrent_exploration.h>
+#include <operational_semantics/compact_lts.h>
+#include <operational_semantics/exploration.h>
+#include <operational_semantics/bisimulation.h>
+#include <operational_semantics/canonical_form.h>
+#include <operational_semantics/disk_state_store.h>
+#include <operational_semantics/lts_file.h>
+#include <operational_semantics/tree_compressed_store.h>
+#include <operational_semantics/bitstate.h>
+#include <operational_semantics/checkpoint.h>
+#include <operational_semantics/instrumentation.h>
 #include <operational_semantics/language_semantics.h>
 #include <operational_semantics/small_step_semantics.h>
+#include <operational_semantics/static_language_semantics.h>
 
 #endif //COTT_OPERATIONAL_SEMANTICS_H
@@ -0,0 +1,486 @@
+/*
+ * bisimulation.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_BISIMULATION_H
+#define COTT_BISIMULATION_H
+
+#include <operational_semantics/compact_lts.h>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <optional>
+#include <vector>
+#include <algorithm>
+
+/**
+ * Equivalence under which an LTS is minimized
+ */
+enum class bisimulation {
+    strong,
+    branching,      ///< Abstracting from the tau steps that do not leave the class of their source
+    weak            ///< Abstracting from all the tau steps, by saturating the graph first
+};
+
+/**
+ * Partition of the elements 0..n-1, where each set occupies a contiguous range of elements. A set is split by marking
+ * some of its elements, which are moved to the front of its range: the larger part keeps the identifier of the set,
+ * while the smaller one takes the next free identifier (Valmari and Lehtinen, 2008).
+ */
+struct refinable_partition {
+    std::vector<std::uint32_t> elements;
+    std::vector<std::uint32_t> location;    ///< Position of each element in elements
+    std::vector<std::uint32_t> set_of;
+    std::vector<std::uint32_t> first;       ///< Range of each set in elements
+    std::vector<std::uint32_t> past;
+    std::vector<std::uint32_t> marked;      ///< Number of marked elements of each set
+    std::vector<std::uint32_t> touched;     ///< Sets having some marked elements
+    std::uint32_t sets = 0;
+
+    /**
+     * Grouping the elements by key, where the keys are smaller than keys
+     */
+    refinable_partition(const std::vector<std::uint32_t>& key, std::uint32_t keys)
+            : elements(key.size()), location(key.size()), set_of(key.size()),
+              first(key.size() + 1), past(key.size() + 1), marked(key.size() + 1) {
+        std::vector<std::uint32_t> offset(keys + 1, 0);
+        for (auto k : key)
+            offset[k + 1]++;
+        for (std::uint32_t k = 0; k<keys; k++)
+            offset[k + 1] += offset[k];
+        std::vector<std::uint32_t> id(keys);
+        for (std::uint32_t k = 0; k<keys; k++)
+            if (offset[k] < offset[k + 1]) {
+                id[k] = sets;
+                first[sets] = offset[k];
+                past[sets++] = offset[k + 1];
+            }
+        for (std::uint32_t e = 0; e<key.size(); e++) {
+            location[e] = offset[key[e]]++;
+            elements[location[e]] = e;
+            set_of[e] = id[key[e]];
+        }
+    }
+
+    std::uint32_t size(std::uint32_t s) const {
+        return past[s] - first[s];
+    }
+
+    void mark(std::uint32_t e) {
+        auto s = set_of[e], i = location[e], j = first[s] + marked[s];
+        if (i < j)
+            return; // Already marked
+        elements[i] = elements[j];
+        location[elements[i]] = i;
+        elements[j] = e;
+        location[e] = j;
+        if (!marked[s]++)
+            touched.emplace_back(s);
+    }
+
+    /**
+     * Splitting the touched sets into their marked and unmarked elements, and notifying each new set alongside the
+     * one it was split from
+     */
+    template <typename F>
+    void split(F&& on_split) {
+        while (!touched.empty()) {
+            auto s = touched.back();
+            touched.pop_back();
+            auto j = first[s] + marked[s];
+            marked[s] = 0;
+            if (j == past[s])
+                continue;
+            if (j - first[s] <= past[s] - j) {
+                first[sets] = first[s];
+                past[sets] = first[s] = j;
+            } else {
+                past[sets] = past[s];
+                first[sets] = past[s] = j;
+            }
+            for (auto i = first[sets]; i<past[sets]; i++)
+                set_of[elements[i]] = sets;
+            on_split(sets++, s);
+        }
+    }
+};
+
+/**
+ * Strong bisimilarity classes of the states 0..states-1 of the given LTS, through Paige and Tarjan's partition
+ * refinement in O(m log n) time. The blocks are kept in constellations, where the blocks of a constellation are
+ * stable with respect to their union. The smaller of two blocks of a compound constellation becomes a constellation
+ * of its own, and each block is split by the states reaching it and by the ones also reaching the rest of its former
+ * constellation, as told by a counter of the transitions from each state per label and constellation.
+ *
+ * @return  The class of each state, as the identifier of its block
+ */
+inline std::vector<std::uint32_t> strong_bisimulation_classes(std::size_t states, std::size_t labels,
+                                                              std::vector<lts_transition> transitions) {
+    constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+    std::sort(transitions.begin(), transitions.end());
+    transitions.erase(std::unique(transitions.begin(), transitions.end()), transitions.end());
+    const auto m = (std::uint32_t)transitions.size();
+
+    // Incoming transitions of each state
+    std::vector<std::uint32_t> in_first(states + 1, 0), incoming(m);
+    for (const auto& t : transitions)
+        in_first[t.target + 1]++;
+    for (std::size_t s = 0; s<states; s++)
+        in_first[s + 1] += in_first[s];
+    {
+        std::vector<std::uint32_t> next(in_first.begin(), in_first.end() - 1);
+        for (std::uint32_t t = 0; t<m; t++)
+            incoming[next[transitions[t].target]++] = t;
+    }
+
+    // Counter of the transitions from each state per label towards the only constellation, holding all the states
+    std::vector<std::uint32_t> counter_of(m), counts, free_counters;
+    for (std::uint32_t t = 0; t<m; t++) {
+        if ((t == 0) || (transitions[t].source != transitions[t - 1].source) || (transitions[t].label != transitions[t - 1].label))
+            counts.emplace_back(0);
+        counter_of[t] = (std::uint32_t)counts.size() - 1;
+        counts.back()++;
+    }
+
+    refinable_partition blocks(std::vector<std::uint32_t>(states, 0), 1);
+    std::vector<std::vector<std::uint32_t>> constellation{{}};  // Blocks of each constellation
+    std::vector<std::uint32_t> constellation_of(states + 1, 0), position(states + 1, 0);
+    std::vector<std::uint32_t> compound;                        // Constellations having at least two blocks
+    if (states > 0)
+        constellation[0].emplace_back(0);
+    auto on_split = [&](std::uint32_t block, std::uint32_t from) {
+        auto& c = constellation[constellation_of[block] = constellation_of[from]];
+        position[block] = (std::uint32_t)c.size();
+        c.emplace_back(block);
+        if (c.size() == 2)
+            compound.emplace_back(constellation_of[from]);
+    };
+
+    // Making the initial partition stable with respect to all the states: splitting by the labels enabled
+    {
+        std::vector<std::vector<std::uint32_t>> sources(labels);
+        for (const auto& t : transitions)
+            if (sources[t.label].empty() || (sources[t.label].back() != t.source))
+                sources[t.label].emplace_back(t.source);
+        for (const auto& l : sources) {
+            for (auto s : l)
+                blocks.mark(s);
+            blocks.split(on_split);
+        }
+    }
+
+    std::vector<std::vector<std::uint32_t>> splitter(labels);  // Transitions towards the splitter, per label
+    std::vector<std::uint32_t> splitter_labels, fresh(states, none), former(states), sources;
+    while (!compound.empty()) {
+        auto c = compound.back();
+        auto& blocks_of_c = constellation[c];
+        if (blocks_of_c.size() < 2) {
+            compound.pop_back();
+            continue;
+        }
+        // Moving the smaller of the first two blocks to a new constellation
+        auto B = (blocks.size(blocks_of_c[0]) <= blocks.size(blocks_of_c[1])) ? blocks_of_c[0] : blocks_of_c[1];
+        blocks_of_c[position[B]] = blocks_of_c.back();
+        position[blocks_of_c[position[B]]] = position[B];
+        blocks_of_c.pop_back();
+        if (blocks_of_c.size() < 2)
+            compound.pop_back();
+        constellation_of[B] = (std::uint32_t)constellation.size();
+        position[B] = 0;
+        constellation.emplace_back(std::vector<std::uint32_t>{B});
+
+        for (auto i = blocks.first[B]; i<blocks.past[B]; i++) {
+            auto x = blocks.elements[i];
+            for (auto j = in_first[x]; j<in_first[x + 1]; j++) {
+                auto t = incoming[j];
+                if (splitter[transitions[t].label].empty())
+                    splitter_labels.emplace_back(transitions[t].label);
+                splitter[transitions[t].label].emplace_back(t);
+            }
+        }
+        for (auto a : splitter_labels) {
+            // Moving the transitions towards B to new counters
+            for (auto t : splitter[a]) {
+                auto s = transitions[t].source;
+                if (fresh[s] == none) {
+                    former[s] = counter_of[t];
+                    if (free_counters.empty()) {
+                        fresh[s] = (std::uint32_t)counts.size();
+                        counts.emplace_back(0);
+                    } else {
+                        fresh[s] = free_counters.back();
+                        free_counters.pop_back();
+                    }
+                    sources.emplace_back(s);
+                }
+                counts[counter_of[t]]--;
+                counts[counter_of[t] = fresh[s]]++;
+            }
+            // Separating the states reaching B, and then the ones not reaching the rest of the former constellation
+            for (auto s : sources)
+                blocks.mark(s);
+            blocks.split(on_split);
+            for (auto s : sources)
+                if (counts[former[s]] == 0)
+                    blocks.mark(s);
+            blocks.split(on_split);
+            for (auto s : sources) {
+                if (counts[former[s]] == 0)
+                    free_counters.emplace_back(former[s]);
+                fresh[s] = none;
+            }
+            sources.clear();
+            splitter[a].clear();
+        }
+        splitter_labels.clear();
+    }
+    return std::move(blocks.set_of);
+}
+
+/**
+ * Strongly connected components of the tau transitions, numbered so that a component reaches through tau steps only
+ * the ones having a smaller identifier (Tarjan, 1972)
+ */
+inline std::vector<std::uint32_t> tau_components(std::size_t states, const std::vector<lts_transition>& transitions,
+                                                 std::uint32_t tau) {
+    constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> tau_first(states + 1, 0), tau_successor;
+    for (const auto& t : transitions)
+        if (t.label == tau)
+            tau_first[t.source + 1]++;
+    for (std::size_t s = 0; s<states; s++)
+        tau_first[s + 1] += tau_first[s];
+    tau_successor.resize(tau_first[states]);
+    {
+        std::vector<std::uint32_t> next(tau_first.begin(), tau_first.end() - 1);
+        for (const auto& t : transitions)
+            if (t.label == tau)
+                tau_successor[next[t.source]++] = t.target;
+    }
+
+    std::vector<std::uint32_t> component(states, none), index(states, none), low(states), stack;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> calls;  // State, and next tau successor to visit
+    std::uint32_t visited = 0, components = 0;
+    for (std::uint32_t root = 0; root<states; root++) {
+        if (index[root] != none)
+            continue;
+        calls.emplace_back(root, tau_first[root]);
+        index[root] = low[root] = visited++;
+        stack.emplace_back(root);
+        while (!calls.empty()) {
+            auto& [s, next] = calls.back();
+            if (next < tau_first[s + 1]) {
+                auto t = tau_successor[next++];
+                if (index[t] == none) {
+                    index[t] = low[t] = visited++;
+                    stack.emplace_back(t);
+                    calls.emplace_back(t, tau_first[t]);
+                } else if (component[t] == none) {
+                    low[s] = std::min(low[s], index[t]);
+                }
+                continue;
+            }
+            auto done = s;
+            calls.pop_back();
+            if (low[done] == index[done]) {
+                std::uint32_t t;
+                do {
+                    t = stack.back();
+                    stack.pop_back();
+                    component[t] = components;
+                } while (t != done);
+                components++;
+            }
+            if (!calls.empty())
+                low[calls.back().first] = std::min(low[calls.back().first], low[done]);
+        }
+    }
+    return component;
+}
+
+/**
+ * Branching bisimilarity classes, by refining the signatures of the states until the number of classes is stable
+ * (Blom and Orzan, 2005). The tau cycles are collapsed first, so that each signature also collects the ones of the
+ * states reached through inert tau steps, which are computed before. Each round takes O(m log m) time, and at most n
+ * rounds are needed.
+ */
+inline std::vector<std::uint32_t> branching_bisimulation_classes(std::size_t states,
+                                                                 const std::vector<lts_transition>& transitions,
+                                                                 std::uint32_t tau) {
+    auto component = tau_components(states, transitions, tau);
+    std::uint32_t n = 0;
+    for (auto c : component)
+        n = std::max(n, c + 1);
+    // Transitions among the components, grouped by source in increasing order
+    std::vector<lts_transition> reduced;
+    for (const auto& t : transitions)
+        if ((t.label != tau) || (component[t.source] != component[t.target]))
+            reduced.push_back({component[t.source], t.label, component[t.target]});
+    std::sort(reduced.begin(), reduced.end());
+    reduced.erase(std::unique(reduced.begin(), reduced.end()), reduced.end());
+
+    using signature = std::vector<std::pair<std::uint32_t, std::uint32_t>>;
+    std::vector<std::uint32_t> block(n, 0), refined(n);
+    std::vector<signature> sig(n);
+    for (std::uint32_t blocks = (n > 0) ? 1 : 0; ; ) {
+        std::map<std::pair<std::uint32_t, signature>, std::uint32_t> ids;
+        for (std::size_t i = 0, s = 0; s<n; s++) {
+            sig[s].clear();
+            for (; (i < reduced.size()) && (reduced[i].source == s); i++) {
+                const auto& t = reduced[i];
+                if ((t.label == tau) && (block[t.target] == block[s]))
+                    sig[s].insert(sig[s].end(), sig[t.target].begin(), sig[t.target].end());
+                else
+                    sig[s].emplace_back(t.label, block[t.target]);
+            }
+            std::sort(sig[s].begin(), sig[s].end());
+            sig[s].erase(std::unique(sig[s].begin(), sig[s].end()), sig[s].end());
+            refined[s] = ids.try_emplace({block[s], sig[s]}, (std::uint32_t)ids.size()).first->second;
+        }
+        block.swap(refined);
+        if (ids.size() == blocks)
+            break;
+        blocks = (std::uint32_t)ids.size();
+    }
+    for (auto& c : component)
+        c = block[c];
+    return component;
+}
+
+/**
+ * Weak bisimilarity classes, as the strong bisimilarity classes after collapsing the tau cycles and saturating the
+ * graph: s =a=> t whenever s reaches t through a, preceded and followed by any tau steps, and s =tau=> t whenever s
+ * reaches t through zero or more tau steps. The saturated graph can have O(n^2) transitions per label.
+ */
+inline std::vector<std::uint32_t> weak_bisimulation_classes(std::size_t states, std::size_t labels,
+                                                            const std::vector<lts_transition>& transitions,
+                                                            std::uint32_t tau) {
+    auto component = tau_components(states, transitions, tau);
+    std::uint32_t n = 0;
+    for (auto c : component)
+        n = std::max(n, c + 1);
+    std::vector<std::vector<lts_transition>> outgoing(n);
+    for (const auto& t : transitions)
+        if ((t.label != tau) || (component[t.source] != component[t.target]))
+            outgoing[component[t.source]].push_back({component[t.source], t.label, component[t.target]});
+
+    // As tau steps only lead to smaller components, the closures are computed in increasing order
+    std::vector<std::vector<std::uint32_t>> closure(n);
+    for (std::uint32_t s = 0; s<n; s++) {
+        closure[s].emplace_back(s);
+        for (const auto& t : outgoing[s])
+            if (t.label == tau)
+                closure[s].insert(closure[s].end(), closure[t.target].begin(), closure[t.target].end());
+        std::sort(closure[s].begin(), closure[s].end());
+        closure[s].erase(std::unique(closure[s].begin(), closure[s].end()), closure[s].end());
+    }
+    std::vector<lts_transition> saturated;
+    for (std::uint32_t s = 0; s<n; s++)
+        for (auto u : closure[s]) {
+            saturated.push_back({s, tau, u});
+            for (const auto& t : outgoing[u])
+                if (t.label != tau)
+                    for (auto v : closure[t.target])
+                        saturated.push_back({s, t.label, v});
+        }
+    auto block = strong_bisimulation_classes(n, labels, std::move(saturated));
+    for (auto& c : component)
+        c = block[c];
+    return component;
+}
+
+/**
+ * Quotient of an LTS under a bisimulation, alongside the class of each of its states
+ */
+template <typename Node, typename Label, typename NodeKeys = structural_keys<Node>>
+struct lts_quotient {
+    using state_id = typename compact_lts<Node, Label, NodeKeys>::state_id;
+
+    /**
+     * One state per class, represented by the term of its first state in the original LTS. The classes are numbered
+     * in order of their first state, so that the class of the original state 0 is 0, and the labels keep their
+     * identifiers.
+     */
+    compact_lts<Node, Label, NodeKeys> lts;
+
+    /**
+     * Class of each original state, as a state of lts
+     */
+    std::vector<state_id> block;
+};
+
+/**
+ * Minimizing a frozen LTS under the given bisimulation. The branching and the weak ones need the label standing for
+ * the internal steps, and drop the tau transitions within a class
+ *
+ * @param lts
+ * @param equivalence
+ * @param tau           The identifier of the internal label, if any appears in lts
+ */
+template <typename Node, typename Label, typename NodeKeys>
+lts_quotient<Node, Label, NodeKeys> minimize(const compact_lts<Node, Label, NodeKeys>& lts,
+                                             bisimulation equivalence = bisimulation::strong,
+                                             std::optional<typename compact_lts<Node, Label, NodeKeys>::label_id> tau = std::nullopt) {
+    using state_id = typename compact_lts<Node, Label, NodeKeys>::state_id;
+    std::vector<lts_transition> transitions;
+    transitions.reserve(lts.edge_count());
+    for (state_id s = 0; s<lts.state_count(); s++)
+        for (const auto& e : lts.successors(s))
+            transitions.push_back({s, e.label, e.target});
+    if (!tau)
+        equivalence = bisimulation::strong;
+
+    std::vector<std::uint32_t> classes;
+    switch (equivalence) {
+        case bisimulation::strong:
+            classes = strong_bisimulation_classes(lts.state_count(), lts.label_count(), std::move(transitions));
+            break;
+        case bisimulation::branching:
+            classes = branching_bisimulation_classes(lts.state_count(), transitions, *tau);
+            break;
+        case bisimulation::weak:
+            classes = weak_bisimulation_classes(lts.state_count(), lts.label_count(), transitions, *tau);
+            break;
+    }
+
+    lts_quotient<Node, Label, NodeKeys> quotient;
+    constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+    std::vector<state_id> id(lts.state_count(), none);
+    quotient.block.resize(lts.state_count());
+    for (state_id s = 0; s<lts.state_count(); s++) {
+        auto& b = id[classes[s]];
+        if (b == none)
+            b = quotient.lts.add_state(lts.term(s)).first;
+        quotient.block[s] = b;
+    }
+    for (std::size_t l = 0; l<lts.label_count(); l++)
+        quotient.lts.add_label(lts.label(l));
+    for (state_id s = 0; s<lts.state_count(); s++)
+        for (const auto& e : lts.successors(s)) {
+            auto src = quotient.block[s], dst = quotient.block[e.target];
+            if ((equivalence == bisimulation::strong) || (e.label != *tau) || (src != dst))
+                quotient.lts.add_edge(src, e.label, dst);
+        }
+    quotient.lts.freeze();
+    return quotient;
+}
+
+#endif //COTT_BISIMULATION_H
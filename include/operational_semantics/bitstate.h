@@ -0,0 +1,147 @@
+/*
+ * bitstate.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_BITSTATE_H
+#define COTT_BITSTATE_H
+
+#include <operational_semantics/exploration.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Fixed-size Bloom filter over the hashes of the visited states, in the style of Holzmann's supertrace: each state
+ * sets hash_count bits, derived from its hash through independent seeds, and a state is deemed visited when all of
+ * them are set. As no state is retained, the memory does not grow with the state space, while a state whose bits were
+ * all set by other states is wrongly deemed visited, and thus omitted alongside the states only reachable through it.
+ */
+struct bitstate_filter {
+    /**
+     * @param bytes         Size of the bit array, rounded up to a multiple of 8 bytes
+     * @param hash_count    Number of bits set by each state
+     */
+    explicit bitstate_filter(std::size_t bytes, unsigned hash_count = 3)
+            : words((bytes + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t)), hash_count{hash_count ? hash_count : 1} {
+        if (words.empty())
+            words.resize(1);
+    }
+
+    /**
+     * Setting the bits of the state with hash h
+     * @return  Whether any of them was not set, i.e. the state was not visited before
+     */
+    bool insert(std::size_t h) {
+        // Before this insertion, a fresh state has this probability of being omitted instead
+        double p = omission_probability();
+        bool fresh = false;
+        for_each_bit(h, [this, &fresh](std::uint64_t bit) {
+            auto& word = words[bit >> 6];
+            auto mask = std::uint64_t(1) << (bit & 63);
+            if (!(word & mask)) {
+                word |= mask;
+                set_bits++;
+                fresh = true;
+            }
+        });
+        if (fresh) {
+            expected_omissions += p / (1.0 - p);
+            inserted++;
+        }
+        return fresh;
+    }
+
+    bool contains(std::size_t h) const {
+        bool all = true;
+        for_each_bit(h, [this, &all](std::uint64_t bit) {
+            all = all && (words[bit >> 6] & (std::uint64_t(1) << (bit & 63)));
+        });
+        return all;
+    }
+
+    /**
+     * @return  Probability that a state not visited yet is deemed visited, given the bits set so far
+     */
+    double omission_probability() const {
+        return std::pow((double)set_bits / (double)bits(), (double)hash_count);
+    }
+
+    /**
+     * @return  Estimated fraction of the reachable states that were visited, by assuming that each state found fresh
+     *          stands for the ones omitted while the filter was as full as when it was inserted
+     */
+    double estimated_coverage() const {
+        return inserted ? (double)inserted / ((double)inserted + expected_omissions) : 1.0;
+    }
+
+    std::size_t bits() const { return words.size() * 64; }
+    std::size_t states() const { return inserted; }
+    std::size_t memory() const { return words.size() * sizeof(std::uint64_t); }
+
+    void clear() {
+        std::fill(words.begin(), words.end(), 0);
+        set_bits = inserted = 0;
+        expected_omissions = 0.0;
+    }
+
+private:
+    /**
+     * Calling f over the bits of the hash h, derived through double hashing from two independently seeded mixes of h
+     */
+    template <typename F>
+    void for_each_bit(std::size_t h, F&& f) const {
+        std::uint64_t h1 = mix((std::uint64_t)h ^ 0x243F6A8885A308D3ull);
+        std::uint64_t h2 = mix((std::uint64_t)h ^ 0x13198A2E03707344ull) | 1;
+        std::uint64_t n = bits();
+        for (unsigned i = 0; i<hash_count; i++)
+            f((h1 + i * h2) % n);
+    }
+
+    /**
+     * Finalizer of MurmurHash3, so that each bit of h affects all the bits of the result
+     */
+    static std::uint64_t mix(std::uint64_t x) {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 33;
+        x *= 0xC4CEB9FE1A85EC53ull;
+        x ^= x >> 33;
+        return x;
+    }
+
+    std::vector<std::uint64_t> words;
+    unsigned hash_count;
+    std::size_t set_bits = 0;
+    std::size_t inserted = 0;
+    double expected_omissions = 0.0;
+};
+
+/**
+ * Outcome of an approximate exploration via a bitstate_filter
+ */
+struct bitstate_result {
+    exploration_result exploration;
+    double coverage = 1.0;                  ///< Estimated fraction of the reachable states visited
+    double omission_probability = 0.0;      ///< Probability that a further state would be wrongly deemed visited
+};
+
+#endif //COTT_BITSTATE_H
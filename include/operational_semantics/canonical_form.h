@@ -0,0 +1,131 @@
+/*
+ * canonical_form.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_CANONICAL_FORM_H
+#define COTT_CANONICAL_FORM_H
+
+#include <operational_semantics/key_hasher.h>
+#include <operational_semantics/term_arena.h>
+#include <algorithm>
+#include <vector>
+
+/**
+ * Describing which constructors of a term are associative and commutative, so that the order and the nesting of
+ * their operands are irrelevant. By default, no constructor is.
+ * @tparam Term
+ */
+template <typename Term>
+struct canonical_form_traits {
+
+    /**
+     * Calling f over each (mutable) children of the term, in a fixed order
+     */
+    template <typename F>
+    static void for_each_child(Term&, F&&) {}
+
+    /**
+     * @return  The operands of the term, if built by an associative and commutative constructor, and null otherwise
+     */
+    static std::vector<std::shared_ptr<Term>>* operands(Term&) {
+        return nullptr;
+    }
+
+    /**
+     * Whether the operand is built by the same associative and commutative constructor as the term, so that its
+     * operands can be merged into the term's ones
+     */
+    static bool same_constructor(const Term&, const Term&) {
+        return false;
+    }
+};
+
+/**
+ * Symmetry reduction for terms: rewriting a term into a canonical representative of the terms equivalent up to
+ * associativity and commutativity of some constructors. The children are rewritten first; then, the operands of an
+ * associative and commutative constructor are flattened, and sorted by hash, while keeping the equal ones adjacent.
+ * Terms whose operands have colliding hashes might then not be identified, which only results in a smaller reduction.
+ * The term is copied via make_term only when rewritten.
+ *
+ * @param t     Term, which is not modified
+ * @return      Canonical term equivalent to t, which is t itself if already canonical
+ */
+template <typename Term, typename Traits = canonical_form_traits<Term>>
+std::shared_ptr<Term> canonical_form(const std::shared_ptr<Term>& t) {
+    if (!t)
+        return t;
+    std::shared_ptr<Term> result = t;
+    std::vector<std::shared_ptr<Term>> children;
+    bool changed = false;
+    Traits::for_each_child(*t, [&children, &changed](std::shared_ptr<Term>& child) {
+        children.emplace_back(canonical_form<Term, Traits>(child));
+        changed = changed || (children.back() != child);
+    });
+    if (changed) {
+        result = make_term<Term>(*t);
+        std::size_t i = 0;
+        Traits::for_each_child(*result, [&children, &i](std::shared_ptr<Term>& child) {
+            child = std::move(children[i++]);
+        });
+    }
+
+    auto* operands = Traits::operands(*result);
+    if (!operands)
+        return result;
+    KeyHasher<Term> hash;
+    std::vector<std::pair<std::size_t, std::shared_ptr<Term>>> flat;
+    for (const auto& operand : *operands) {
+        if (operand && Traits::same_constructor(*result, *operand))
+            for (const auto& nested : *Traits::operands(*operand))
+                flat.emplace_back(hash(nested), nested);
+        else
+            flat.emplace_back(hash(operand), operand);
+    }
+    std::stable_sort(flat.begin(), flat.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+    // Within each run of equal hashes, moving the operands equal to the first ones next to them
+    KeyEqualizer<Term> equal;
+    for (std::size_t begin = 0; begin<flat.size(); ) {
+        std::size_t end = begin + 1;
+        while ((end < flat.size()) && (flat[end].first == flat[begin].first))
+            end++;
+        for (std::size_t i = begin; i + 1<end; i++)
+            for (std::size_t j = i + 1; j<end; j++)
+                if (equal(flat[i].second, flat[j].second)) {
+                    std::rotate(flat.begin() + i + 1, flat.begin() + j, flat.begin() + j + 1);
+                    break;
+                }
+        begin = end;
+    }
+    bool reordered = flat.size() != operands->size();
+    for (std::size_t i = 0; (!reordered) && (i < flat.size()); i++)
+        reordered = flat[i].second != (*operands)[i];
+    if (!reordered)
+        return result;
+    if (result == t)
+        result = make_term<Term>(*t);
+    operands = Traits::operands(*result);
+    operands->clear();
+    for (auto& [h, operand] : flat)
+        operands->emplace_back(std::move(operand));
+    return result;
+}
+
+#endif //COTT_CANONICAL_FORM_H
@@ -0,0 +1,318 @@
+/*
+ * checkpoint.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_CHECKPOINT_H
+#define COTT_CHECKPOINT_H
+
+#include <operational_semantics/is_serializable.h>
+#include <memory>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Append-only log of a graph being generated, from which an interrupted exploration is resumed. The states and the
+ * labels are appended, serialized, when first seen, and the edges as triples of their numbers, so that each checkpoint
+ * only writes what was generated since the previous one, followed by a commit record listing the roots and the states
+ * still to be expanded. The log is flushed at each commit, and resuming reads it up to the last complete commit,
+ * discarding anything written after it.
+ *
+ * Setting it into small_step_semantics::checkpoint makes visit and add_root record into it, the former truncating it
+ * first, while small_step_semantics::resume restores the graph from it and carries on recording. The states are
+ * numbered by their address, as the semantics only records the instances it stores in its visited set, and the log
+ * shares their ownership, so that an address is not reused by another state after the semantics is cleared.
+ *
+ * @tparam Node
+ * @tparam Label
+ */
+template <typename Node, typename Label>
+struct exploration_checkpoint {
+    static_assert(is_serializable_v<Node>, "Error: the node type should be serializable, so to be checkpointed");
+    static_assert(is_serializable_v<Label>, "Error: the label type should be serializable, so to be checkpointed");
+
+    using node_ptr = std::shared_ptr<Node>;
+
+    /**
+     * States of the graph restored from a checkpoint
+     */
+    struct restored {
+        std::vector<node_ptr> roots;
+        std::vector<node_ptr> pending;      ///< Visited states not expanded yet
+    };
+
+    /**
+     * @param path              Log file, which is only opened, and truncated, when first written or restored
+     * @param every_expansions  Expansions between two checkpoints, or zero for not checkpointing by expansions
+     * @param every             Time between two checkpoints, or zero for not checkpointing by time
+     */
+    explicit exploration_checkpoint(std::filesystem::path path, std::size_t every_expansions = 100000,
+                                    std::chrono::milliseconds every = std::chrono::milliseconds{0})
+            : path{std::move(path)}, every_expansions{every_expansions}, every{every} {}
+
+    /**
+     * Truncating the log, as a new graph is being generated
+     */
+    void reset() {
+        file.close();
+        file.open(path, std::ios::binary | std::ios::trunc | std::ios::out);
+        if (!file)
+            throw std::system_error(errno, std::generic_category(), path.string());
+        file.write(magic, sizeof(magic));
+        write_integer(version);
+        ids.clear();
+        label_ids.clear();
+        commits = 0;
+        since = 0;
+        last = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * @return  The number of the state, appending it to the log if not seen before
+     */
+    std::uint32_t add_state(const node_ptr& t) {
+        if (!file.is_open())
+            reset();
+        auto [it, inserted] = ids.try_emplace(t, (std::uint32_t)ids.size());
+        if (inserted) {
+            buffer.clear();
+            serialization_traits<Node>::write(*t, buffer);
+            file.put('S');
+            write_integer((std::uint32_t)buffer.size());
+            file.write(buffer.data(), (std::streamsize)buffer.size());
+        }
+        return it->second;
+    }
+
+    /**
+     * Discarding the recorded graph, as the semantics generating it was cleared: its states are released, e.g. before
+     * their arena is freed, while the log is closed, so that it can still be resumed from until it is truncated by
+     * the next recording
+     */
+    void discard() {
+        file.close();
+        ids.clear();
+    }
+
+    void add_edge(const node_ptr& src, const Label& label, const node_ptr& dst) {
+        if (!file.is_open())
+            reset();
+        auto [it, inserted] = label_ids.try_emplace(label, (std::uint32_t)label_ids.size());
+        if (inserted) {
+            buffer.clear();
+            serialization_traits<Label>::write(label, buffer);
+            file.put('L');
+            write_integer((std::uint32_t)buffer.size());
+            file.write(buffer.data(), (std::streamsize)buffer.size());
+        }
+        std::uint32_t triple[3] = {add_state(src), it->second, add_state(dst)};
+        file.put('E');
+        file.write((const char*)triple, sizeof(triple));
+    }
+
+    /**
+     * Counting an expansion
+     * @return  Whether a checkpoint is due
+     */
+    bool expanded() {
+        if ((every_expansions > 0) && (++since >= every_expansions))
+            return true;
+        return (every.count() > 0) && (std::chrono::steady_clock::now() - last >= every);
+    }
+
+    /**
+     * Appending a commit record, and flushing the log
+     * @param roots
+     * @param pending   Visited states not expanded yet
+     */
+    template <typename Roots, typename Pending>
+    void commit(const Roots& roots, const Pending& pending) {
+        if (!file.is_open())
+            reset();
+        buffer.clear();
+        serialization_traits<std::uint64_t>::write(roots.size(), buffer);
+        for (const auto& t : roots)
+            serialization_traits<std::uint32_t>::write(add_state(t), buffer);
+        serialization_traits<std::uint64_t>::write(pending.size(), buffer);
+        for (const auto& t : pending)
+            serialization_traits<std::uint32_t>::write(add_state(t), buffer);
+        file.put('C');
+        write_integer((std::uint64_t)buffer.size());
+        file.write(buffer.data(), (std::streamsize)buffer.size());
+        file.flush();
+        if (!file)
+            throw std::system_error(errno, std::generic_category(), path.string());
+        commits++;
+        since = 0;
+        last = std::chrono::steady_clock::now();
+    }
+
+    /**
+     * Reading the log up to its last complete commit, which is where the next records will be appended
+     * @param canonical     Mapping each state read back to the one stored by the semantics
+     * @param on_state      Called over each state, in order of first appearance, which is then stored as is
+     * @param on_edge       Called over each edge, after its states
+     */
+    template <typename Canonical, typename OnState, typename OnEdge>
+    restored restore(Canonical&& canonical, OnState&& on_state, OnEdge&& on_edge) {
+        file.close();
+        std::ifstream in{path, std::ios::binary};
+        if (!in)
+            throw std::system_error(errno, std::generic_category(), path.string());
+        auto end = last_commit(in);
+        if (!end)
+            throw std::runtime_error(path.string() + ": no complete checkpoint");
+        in.clear();
+        in.seekg(sizeof(magic) + sizeof(version));
+        ids.clear();
+        label_ids.clear();
+        std::vector<node_ptr> states;
+        std::vector<Label> labels;
+        restored result;
+        commits = 0;
+        for (std::uint64_t offset = sizeof(magic) + sizeof(version); offset < end; ) {
+            char tag = (char)in.get();
+            if ((tag == 'S') || (tag == 'L')) {
+                auto length = read_integer<std::uint32_t>(in);
+                offset += 1 + sizeof(length) + length;
+                read_bytes(in, length);
+                const char* p = buffer.data();
+                if (tag == 'S') {
+                    auto t = canonical(std::make_shared<Node>(serialization_traits<Node>::read(p)));
+                    ids.try_emplace(t, (std::uint32_t)states.size());
+                    states.emplace_back(t);
+                    on_state(t);
+                } else {
+                    labels.emplace_back(serialization_traits<Label>::read(p));
+                    label_ids.try_emplace(labels.back(), (std::uint32_t)(labels.size() - 1));
+                }
+            } else if (tag == 'E') {
+                std::uint32_t triple[3];
+                in.read((char*)triple, sizeof(triple));
+                offset += 1 + sizeof(triple);
+                on_edge(states.at(triple[0]), labels.at(triple[1]), states.at(triple[2]));
+            } else {
+                auto length = read_integer<std::uint64_t>(in);
+                offset += 1 + sizeof(length) + length;
+                read_bytes(in, length);
+                const char* p = buffer.data();
+                result.roots.clear();
+                result.pending.clear();
+                for (auto n = serialization_traits<std::uint64_t>::read(p); n > 0; n--)
+                    result.roots.emplace_back(states.at(serialization_traits<std::uint32_t>::read(p)));
+                for (auto n = serialization_traits<std::uint64_t>::read(p); n > 0; n--)
+                    result.pending.emplace_back(states.at(serialization_traits<std::uint32_t>::read(p)));
+                commits++;
+            }
+        }
+        in.close();
+        std::filesystem::resize_file(path, end);
+        file.open(path, std::ios::binary | std::ios::app);
+        if (!file)
+            throw std::system_error(errno, std::generic_category(), path.string());
+        since = 0;
+        last = std::chrono::steady_clock::now();
+        return result;
+    }
+
+    /**
+     * @return  Number of commits in the log
+     */
+    std::size_t commit_count() const {
+        return commits;
+    }
+
+    const std::filesystem::path path;
+    std::size_t every_expansions;
+    std::chrono::milliseconds every;
+
+private:
+    static constexpr char magic[8] = {'C', 'O', 'T', 'T', 'C', 'K', 'P', '\0'};
+    static constexpr std::uint32_t version = 1;
+
+    template <typename T>
+    void write_integer(T x) {
+        file.write((const char*)&x, sizeof(x));
+    }
+
+    template <typename T>
+    static T read_integer(std::istream& in) {
+        T x = 0;
+        in.read((char*)&x, sizeof(x));
+        return x;
+    }
+
+    void read_bytes(std::istream& in, std::size_t length) {
+        buffer.resize(length);
+        in.read(buffer.data(), (std::streamsize)length);
+    }
+
+    /**
+     * @return  The offset following the last complete commit record, if any, by skipping over the records
+     */
+    static std::uint64_t last_commit(std::istream& in) {
+        in.seekg(0, std::ios::end);
+        auto size = (std::uint64_t)in.tellg();
+        in.seekg(0);
+        char header[sizeof(magic)];
+        in.read(header, sizeof(header));
+        if (!in || (std::char_traits<char>::compare(header, magic, sizeof(magic)) != 0) || (read_integer<std::uint32_t>(in) != version))
+            throw std::runtime_error("Not a checkpoint of this version");
+        std::uint64_t end = 0;
+        for (std::uint64_t offset = sizeof(magic) + sizeof(version); offset < size; ) {
+            in.seekg((std::streamoff)offset);
+            int tag = in.get();
+            std::uint64_t length;
+            if ((tag == 'S') || (tag == 'L'))
+                length = sizeof(std::uint32_t) + read_integer<std::uint32_t>(in);
+            else if (tag == 'E')
+                length = 3 * sizeof(std::uint32_t);
+            else if (tag == 'C')
+                length = sizeof(std::uint64_t) + read_integer<std::uint64_t>(in);
+            else
+                break;
+            offset += 1 + length;
+            // A record torn by an interruption ends past the end of the log
+            if (!in || (offset > size))
+                break;
+            if (tag == 'C')
+                end = offset;
+        }
+        return end;
+    }
+
+    std::ofstream file;
+    std::unordered_map<node_ptr, std::uint32_t> ids;
+    std::unordered_map<Label, std::uint32_t> label_ids;
+    std::string buffer;
+    std::size_t commits = 0;
+    std::size_t since = 0;      ///< Expansions since the last commit
+    std::chrono::steady_clock::time_point last = std::chrono::steady_clock::now();
+};
+
+#endif //COTT_CHECKPOINT_H
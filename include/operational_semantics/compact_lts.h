@@ -0,0 +1,220 @@
+/*
+ * compact_lts.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_COMPACT_LTS_H
+#define COTT_COMPACT_LTS_H
+
+#include <operational_semantics/key_hasher.h>
+#include <cstdint>
+#include <vector>
+#include <unordered_map>
+#include <optional>
+#include <algorithm>
+#include <span>
+
+/**
+ * Edge of an LTS, as the identifiers of its source, label and target
+ */
+struct lts_transition {
+    std::uint32_t source;
+    std::uint32_t label;
+    std::uint32_t target;
+
+    bool operator==(const lts_transition&) const = default;
+    auto operator<=>(const lts_transition&) const = default;
+};
+
+/**
+ * Labelled transition system where the states and the labels are referred to by dense integer identifiers, assigned
+ * in order of discovery. The edges are appended while exploring, and then frozen into a compressed sparse row layout,
+ * where the outgoing edges of each state are contiguous and sorted by label and target.
+ *
+ * @tparam Node
+ * @tparam Label
+ * @tparam NodeKeys     How the states are identified, as in small_step_semantics
+ */
+template <typename Node,
+        typename Label,
+        typename NodeKeys = structural_keys<Node>>
+struct compact_lts {
+    using state_id = std::uint32_t;
+    using label_id = std::uint32_t;
+
+    struct edge {
+        label_id label;
+        state_id target;
+
+        bool operator==(const edge&) const = default;
+        auto operator<=>(const edge&) const = default;
+    };
+
+    /**
+     * Memory used by the representation, in bytes. The terms themselves are not accounted, as they might be shared
+     * with other data structures
+     */
+    struct memory_usage {
+        std::size_t states = 0;     ///< Identifier-to-term table
+        std::size_t index = 0;      ///< Term-to-identifier hash table
+        std::size_t labels = 0;     ///< Label tables
+        std::size_t edges = 0;      ///< Row offsets and edges
+
+        std::size_t total() const { return states + index + labels + edges; }
+    };
+
+    /**
+     * Assigning the next identifier to the state, if no equivalent state was already added
+     * @return  The identifier of the state, and whether it was newly added
+     */
+    std::pair<state_id, bool> add_state(const std::shared_ptr<Node>& t) {
+        auto [it, inserted] = index.try_emplace(t, (state_id)terms.size());
+        if (inserted)
+            terms.emplace_back(t);
+        return {it->second, inserted};
+    }
+
+    label_id add_label(const Label& l) {
+        auto [it, inserted] = label_index.try_emplace(l, (label_id)label_values.size());
+        if (inserted)
+            label_values.emplace_back(l);
+        return it->second;
+    }
+
+    /**
+     * Appending an edge, which becomes visible through successors only after freeze
+     */
+    void add_edge(state_id src, label_id label, state_id dst) {
+        appended.push_back({src, {label, dst}});
+    }
+
+    /**
+     * Moving the appended edges into the compressed sparse row layout, also merging the duplicated ones. The edges
+     * added after this are appended to the frozen ones at the next freeze.
+     */
+    void freeze() {
+        for (state_id s = 0, N = (state_id)offsets.size() - (offsets.empty() ? 0 : 1); s<N; s++)
+            for (std::size_t i = offsets[s]; i<offsets[s+1]; i++)
+                appended.push_back({s, edges[i]});
+        offsets.assign(terms.size() + 1, 0);
+        for (const auto& [src, e] : appended)
+            offsets[src + 1]++;
+        for (std::size_t s = 0; s<terms.size(); s++)
+            offsets[s + 1] += offsets[s];
+        edges.resize(appended.size());
+        {
+            std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+            for (const auto& [src, e] : appended)
+                edges[next[src]++] = e;
+        }
+        appended.clear();
+        appended.shrink_to_fit();
+        // Sorting and deduplicating each row, while compacting the rows towards the beginning
+        std::size_t write = 0;
+        for (std::size_t s = 0; s<terms.size(); s++) {
+            auto begin = edges.begin() + offsets[s], end = edges.begin() + offsets[s + 1];
+            std::sort(begin, end);
+            end = std::unique(begin, end);
+            offsets[s] = write;
+            write = std::move(begin, end, edges.begin() + write) - edges.begin();
+        }
+        offsets[terms.size()] = write;
+        edges.resize(write);
+        edges.shrink_to_fit();
+    }
+
+    std::size_t state_count() const { return terms.size(); }
+    std::size_t label_count() const { return label_values.size(); }
+    std::size_t edge_count() const { return edges.size(); }
+
+    /**
+     * @return  The outgoing edges of the state, as of the last freeze
+     */
+    std::span<const edge> successors(state_id s) const {
+        if ((std::size_t)s + 1 >= offsets.size())
+            return {};
+        return {edges.data() + offsets[s], edges.data() + offsets[s + 1]};
+    }
+
+    const std::shared_ptr<Node>& term(state_id s) const {
+        return terms[s];
+    }
+
+    const Label& label(label_id l) const {
+        return label_values[l];
+    }
+
+    std::optional<state_id> find(const std::shared_ptr<Node>& t) const {
+        auto it = index.find(t);
+        if (it == index.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    std::optional<label_id> find_label(const Label& l) const {
+        auto it = label_index.find(l);
+        if (it == label_index.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    memory_usage memory() const {
+        // Each hash table entry is a node holding the value, the next pointer and the cached hash
+        constexpr std::size_t node_overhead = 2 * sizeof(void*);
+        memory_usage m;
+        m.states = terms.capacity() * sizeof(std::shared_ptr<Node>);
+        m.index = index.size() * (sizeof(typename decltype(index)::value_type) + node_overhead) +
+                  index.bucket_count() * sizeof(void*);
+        m.labels = label_values.capacity() * sizeof(Label) +
+                   label_index.size() * (sizeof(typename decltype(label_index)::value_type) + node_overhead) +
+                   label_index.bucket_count() * sizeof(void*);
+        m.edges = offsets.capacity() * sizeof(std::size_t) + edges.capacity() * sizeof(edge) +
+                  appended.capacity() * sizeof(std::pair<state_id, edge>);
+        return m;
+    }
+
+    /**
+     * @return  Average bytes per state, over the whole representation
+     */
+    double bytes_per_state() const {
+        return terms.empty() ? 0.0 : (double)memory().total() / (double)terms.size();
+    }
+
+    void clear() {
+        terms.clear();
+        index.clear();
+        label_values.clear();
+        label_index.clear();
+        offsets.clear();
+        edges.clear();
+        appended.clear();
+    }
+
+private:
+    std::vector<std::shared_ptr<Node>> terms;
+    std::unordered_map<std::shared_ptr<Node>, state_id, typename NodeKeys::hasher, typename NodeKeys::equalizer> index;
+    std::vector<Label> label_values;
+    std::unordered_map<Label, label_id> label_index;
+    std::vector<std::size_t> offsets;
+    std::vector<edge> edges;
+    std::vector<std::pair<state_id, edge>> appended;
+};
+
+#endif //COTT_COMPACT_LTS_H
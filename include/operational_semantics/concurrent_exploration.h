@@ -0,0 +1,126 @@
+/*
+ * concurrent_exploration.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_CONCURRENT_EXPLORATION_H
+#define COTT_CONCURRENT_EXPLORATION_H
+
+#include <memory>
+#include <mutex>
+#include <deque>
+#include <optional>
+#include <unordered_set>
+#include <bit>
+
+/**
+ * Set of nodes that can be concurrently updated, as it is partitioned into independently locked shards. Each node is
+ * hashed once, and stored alongside its hash
+ * @tparam Node
+ * @tparam Hasher       Hasher for the node pointers
+ * @tparam Equalizer    Equality predicate for the node pointers
+ */
+template <typename Node, typename Hasher, typename Equalizer>
+struct sharded_node_set {
+
+    /**
+     * @param min_shards    Minimum number of shards, which is rounded up to a power of two
+     */
+    explicit sharded_node_set(std::size_t min_shards = 64) : bits{(std::size_t)std::bit_width(std::bit_ceil(std::max<std::size_t>(min_shards, 2)) - 1)},
+                                                            shards{new shard[std::size_t(1) << bits]} {}
+
+    /**
+     * Inserting a node, if no equivalent node is already there
+     * @return  Whether the node was inserted
+     */
+    bool insert(const std::shared_ptr<Node>& t) {
+        std::size_t h = Hasher()(t);
+        auto& s = shards[(h * 0x9E3779B97F4A7C15ull) >> (64 - bits)];
+        std::lock_guard<std::mutex> lock{s.mutex};
+        return s.nodes.insert({h, t}).second;
+    }
+
+    /**
+     * Moving all the nodes to f, thus emptying the set. This shall not run concurrently with insert
+     */
+    template <typename F>
+    void drain(F&& f) {
+        for (std::size_t i = 0, N = std::size_t(1) << bits; i<N; i++) {
+            for (const auto& e : shards[i].nodes)
+                f(e.node);
+            shards[i].nodes.clear();
+        }
+    }
+
+private:
+    struct entry {
+        std::size_t hash;
+        std::shared_ptr<Node> node;
+    };
+    struct entry_hasher {
+        std::size_t operator()(const entry& e) const { return e.hash; }
+    };
+    struct entry_equalizer {
+        bool operator()(const entry& x, const entry& y) const { return (x.hash == y.hash) && Equalizer()(x.node, y.node); }
+    };
+    struct shard {
+        std::mutex mutex;
+        std::unordered_set<entry, entry_hasher, entry_equalizer> nodes;
+    };
+
+    std::size_t bits;
+    std::unique_ptr<shard[]> shards;
+};
+
+/**
+ * Deque of pending work: the owner thread pushes and pops at the back, while the other threads steal from the front
+ * @tparam T
+ */
+template <typename T>
+struct work_stealing_deque {
+    void push(T t) {
+        std::lock_guard<std::mutex> lock{mutex};
+        items.push_back(std::move(t));
+    }
+
+    std::optional<T> pop() {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (items.empty())
+            return std::nullopt;
+        T t = std::move(items.back());
+        items.pop_back();
+        return t;
+    }
+
+    std::optional<T> steal() {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (items.empty())
+            return std::nullopt;
+        T t = std::move(items.front());
+        items.pop_front();
+        return t;
+    }
+
+private:
+    std::mutex mutex;
+    std::deque<T> items;
+};
+
+#endif //COTT_CONCURRENT_EXPLORATION_H
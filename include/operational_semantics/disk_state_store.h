@@ -0,0 +1,332 @@
+/*
+ * disk_state_store.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_DISK_STATE_STORE_H
+#define COTT_DISK_STATE_STORE_H
+
+#include <operational_semantics/is_serializable.h>
+#include <operational_semantics/key_hasher.h>
+#include <operational_semantics/compact_lts.h>
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/**
+ * Append-only file, read back through a memory mapping. The appended bytes are buffered, and written when the buffer
+ * fills up or when they are read back. The mapping grows geometrically with the file, so that it is seldom remapped.
+ */
+struct mapped_file {
+    static constexpr std::size_t buffer_size = 1 << 20;
+
+    /**
+     * Creating the file, or truncating it if it exists
+     * @param keep  Whether the file is kept after closing it, or removed
+     */
+    explicit mapped_file(std::filesystem::path path, bool keep = false) : path{std::move(path)}, keep{keep} {
+        fd = ::open(this->path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), this->path.string());
+    }
+
+    /**
+     * Creating a new file, whose name is prefix followed by a unique suffix, so that no existing file is overwritten
+     * and that concurrent users of the same prefix get distinct files
+     * @param keep  Whether the file is kept after closing it, or removed
+     */
+    static mapped_file unique(const std::filesystem::path& prefix, bool keep = false) {
+        std::string name = prefix.string() + "XXXXXX";
+        int fd = ::mkstemp(name.data());
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), name);
+        return mapped_file{std::move(name), fd, keep};
+    }
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    ~mapped_file() {
+        if (map)
+            ::munmap(map, mapped);
+        ::close(fd);
+        if (!keep) {
+            std::error_code ignored;
+            std::filesystem::remove(path, ignored);
+        }
+    }
+
+    /**
+     * @return  The offset of the appended bytes
+     */
+    std::uint64_t append(const char* bytes, std::size_t length) {
+        auto offset = size();
+        buffer.append(bytes, length);
+        if (buffer.size() >= buffer_size)
+            flush();
+        return offset;
+    }
+
+    /**
+     * @return  Pointer to length bytes at offset, which were appended as a whole by a single append. This is valid
+     *          until the next call to append or to data
+     */
+    const char* data(std::uint64_t offset, std::size_t length) {
+        if (offset >= written)
+            return buffer.data() + (offset - written);
+        if (offset + length > mapped) {
+            if (map)
+                ::munmap(map, mapped);
+            mapped = std::max<std::size_t>(written, 2 * mapped);
+            map = (char*)::mmap(nullptr, mapped, PROT_READ, MAP_SHARED, fd, 0);
+            if (map == MAP_FAILED) {
+                map = nullptr;
+                mapped = 0;
+                throw std::system_error(errno, std::generic_category(), path.string());
+            }
+        }
+        return map + offset;
+    }
+
+    /**
+     * Writing the buffered bytes to the file
+     */
+    void flush() {
+        for (std::size_t done = 0; done < buffer.size(); ) {
+            auto n = ::write(fd, buffer.data() + done, buffer.size() - done);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), path.string());
+            }
+            done += n;
+        }
+        written += buffer.size();
+        buffer.clear();
+    }
+
+    std::uint64_t size() const {
+        return written + buffer.size();
+    }
+
+    const std::filesystem::path path;
+
+private:
+    mapped_file(std::filesystem::path path, int fd, bool keep) : path{std::move(path)}, keep{keep}, fd{fd} {}
+
+    bool keep;
+    int fd = -1;
+    std::string buffer;
+    std::uint64_t written = 0;      ///< Bytes written to the file, the following ones being buffered
+    char* map = nullptr;
+    std::size_t mapped = 0;
+};
+
+/**
+ * Storage for state spaces larger than the RAM, where the serialized states and the edges are appended to files in a
+ * directory, and read back through memory mappings. The files are created with unique names, so that several stores
+ * share a directory without overwriting each other's files, or any other file. The RAM only holds the labels, and a hash index over the states,
+ * taking about 24 bytes per state: the offset of each state in the file, its hash, and an open addressing table of
+ * state identifiers. Finding a state only reads back the states with the same hash. The states are numbered in order
+ * of insertion, and the ones numbered below expanded were already expanded by an exploration.
+ *
+ * @tparam Node
+ * @tparam Label
+ */
+template <typename Node, typename Label>
+struct disk_state_store {
+    static_assert(is_serializable_v<Node>, "Error: the node type should be serializable, so to be stored on disk");
+    static_assert(is_std_hashable_v<Node>, "Error: the node type should be hashable, so to be indexed");
+    static_assert(CHECK::EqualExists<Node>::value, "Error: the node type should have an equivalence operator associated to it, so to detect the duplicated states");
+
+    using state_id = std::uint32_t;
+    using label_id = std::uint32_t;
+
+    /**
+     * @param directory     Where the files are created, which shall exist
+     * @param keep          Whether the files are kept when the store is destroyed, at states_path and edges_path
+     * @param prefix        Prefix of the file names, which are followed by a unique suffix
+     */
+    explicit disk_state_store(const std::filesystem::path& directory, bool keep = false, const std::string& prefix = "cott_")
+            : states_file{mapped_file::unique(directory / (prefix + "states_"), keep)},
+              edges_file{mapped_file::unique(directory / (prefix + "edges_"), keep)},
+              slots(1024, none) {}
+
+    /**
+     * Storing the state, if no equivalent state was already stored
+     * @return  The identifier of the state, and whether it was newly stored
+     */
+    std::pair<state_id, bool> add_state(const std::shared_ptr<Node>& t) {
+        serialize(t);
+        std::size_t h = KeyHasher<Node>()(t);
+        if (auto id = lookup(t, h))
+            return {*id, false};
+        if ((offsets.size() + 1) * 4 > slots.size() * 3)
+            rehash(slots.size() * 2);
+        auto id = (state_id)offsets.size();
+        offsets.emplace_back(states_file.append(record.data(), record.size()));
+        hashes.emplace_back(h);
+        slots[free_slot(h)] = id;
+        return {id, true};
+    }
+
+    std::optional<state_id> find(const std::shared_ptr<Node>& t) {
+        serialize(t);
+        return lookup(t, KeyHasher<Node>()(t));
+    }
+
+    /**
+     * @return  The state, read back from the file
+     */
+    std::shared_ptr<Node> state(state_id s) {
+        const char* in = read_record(s) + sizeof(std::uint32_t);
+        return std::make_shared<Node>(serialization_traits<Node>::read(in));
+    }
+
+    label_id add_label(const Label& l) {
+        auto [it, inserted] = label_index.try_emplace(l, (label_id)label_values.size());
+        if (inserted)
+            label_values.emplace_back(l);
+        return it->second;
+    }
+
+    const Label& label(label_id l) const {
+        return label_values[l];
+    }
+
+    void add_edge(state_id src, label_id label, state_id dst) {
+        lts_transition e{src, label, dst};
+        edges_file.append((const char*)&e, sizeof(e));
+    }
+
+    /**
+     * Calling f over each edge, as an lts_transition, in order of insertion
+     */
+    template <typename F>
+    void for_each_edge(F&& f) {
+        for (std::size_t i = 0, N = edge_count(); i<N; i++) {
+            lts_transition e;
+            std::memcpy(&e, edges_file.data(i * sizeof(e), sizeof(e)), sizeof(e));
+            f(e);
+        }
+    }
+
+    std::size_t state_count() const { return offsets.size(); }
+    std::size_t label_count() const { return label_values.size(); }
+    std::size_t edge_count() const { return edges_file.size() / sizeof(lts_transition); }
+
+    /**
+     * @return  Bytes held in RAM, besides the pages of the files cached by the operating system
+     */
+    std::size_t memory() const {
+        return offsets.capacity() * sizeof(std::uint64_t) + hashes.capacity() * sizeof(std::size_t) +
+               slots.capacity() * sizeof(state_id) + label_values.capacity() * sizeof(Label) +
+               label_index.size() * (sizeof(typename decltype(label_index)::value_type) + 2 * sizeof(void*)) +
+               2 * mapped_file::buffer_size;
+    }
+
+    const std::filesystem::path& states_path() const { return states_file.path; }
+    const std::filesystem::path& edges_path() const { return edges_file.path; }
+
+    /**
+     * @return  Bytes stored on disk
+     */
+    std::uint64_t disk_usage() const {
+        return states_file.size() + edges_file.size();
+    }
+
+    /**
+     * Number of states already expanded, as an exploration expands them in order
+     */
+    std::size_t expanded = 0;
+
+private:
+    static constexpr state_id none = std::numeric_limits<state_id>::max();
+
+    /**
+     * Serializing the state into record, prefixed by its length, so that it is appended as a whole
+     */
+    void serialize(const std::shared_ptr<Node>& t) {
+        record.assign(sizeof(std::uint32_t), '\0');
+        serialization_traits<Node>::write(*t, record);
+        std::uint32_t length = (std::uint32_t)(record.size() - sizeof(std::uint32_t));
+        std::memcpy(record.data(), &length, sizeof(length));
+    }
+
+    /**
+     * @return  The record of the state, i.e. its length followed by its serialization
+     */
+    const char* read_record(state_id s) {
+        std::uint32_t length;
+        std::memcpy(&length, states_file.data(offsets[s], sizeof(length)), sizeof(length));
+        return states_file.data(offsets[s], sizeof(length) + length);
+    }
+
+    /**
+     * Finding the state whose record is in record, and whose hash is h
+     */
+    std::optional<state_id> lookup(const std::shared_ptr<Node>& t, std::size_t h) {
+        for (std::size_t i = h & (slots.size() - 1); slots[i] != none; i = (i + 1) & (slots.size() - 1)) {
+            auto s = slots[i];
+            if (hashes[s] != h)
+                continue;
+            const char* in = read_record(s);
+            // The same bytes stand for the same state, while different ones might still be equivalent
+            if ((std::memcmp(in, record.data(), sizeof(std::uint32_t)) == 0) &&
+                (std::memcmp(in, record.data(), record.size()) == 0))
+                return s;
+            in += sizeof(std::uint32_t);
+            if (serialization_traits<Node>::read(in) == *t)
+                return s;
+        }
+        return std::nullopt;
+    }
+
+    std::size_t free_slot(std::size_t h) const {
+        std::size_t i = h & (slots.size() - 1);
+        while (slots[i] != none)
+            i = (i + 1) & (slots.size() - 1);
+        return i;
+    }
+
+    void rehash(std::size_t size) {
+        slots.assign(size, none);
+        for (state_id s = 0; s<offsets.size(); s++)
+            slots[free_slot(hashes[s])] = s;
+    }
+
+    mapped_file states_file, edges_file;
+    std::vector<std::uint64_t> offsets;
+    std::vector<std::size_t> hashes;
+    std::vector<state_id> slots;
+    std::vector<Label> label_values;
+    std::unordered_map<Label, label_id> label_index;
+    std::string record;                 ///< Record of the last state added or found
+};
+
+#endif //COTT_DISK_STATE_STORE_H
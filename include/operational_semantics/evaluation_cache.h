@@ -0,0 +1,119 @@
+/*
+ * evaluation_cache.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_EVALUATION_CACHE_H
+#define COTT_EVALUATION_CACHE_H
+
+#include <operational_semantics/key_hasher.h>
+#include <unordered_map>
+#include <list>
+
+/**
+ * Memoization table associating each (structurally distinct) term to its evaluation. When a capacity is given,
+ * the least recently used entry is evicted as soon as the capacity is exceeded.
+ *
+ * @tparam Key      Term type, which should be hashable and come with an equality predicate
+ * @tparam Value    Cached evaluation
+ */
+template <typename Key, typename Value>
+struct evaluation_cache {
+
+    /**
+     * @param capacity  Maximum number of cached terms, where zero stands for an unbounded cache
+     */
+    explicit evaluation_cache(std::size_t capacity = 0) : capacity{capacity} {}
+
+    /**
+     * Looking up the evaluation of a term, which also refreshes the term as the most recently used one
+     * @param t     Term
+     * @return      Null if the term was not cached, and the cached evaluation otherwise
+     */
+    const Value* find(const std::shared_ptr<Key>& t) {
+        auto it = index.find(t);
+        if (it == index.end()) {
+            misses++;
+            return nullptr;
+        }
+        hits++;
+        lru.splice(lru.begin(), lru, it->second);
+        return &it->second->second;
+    }
+
+    /**
+     * Caching the evaluation of a term, possibly evicting the least recently used one
+     * @param t     Term
+     * @param v     Evaluation of the term
+     */
+    void insert(const std::shared_ptr<Key>& t, Value v) {
+        auto it = index.find(t);
+        if (it != index.end()) {
+            it->second->second = std::move(v);
+            lru.splice(lru.begin(), lru, it->second);
+            return;
+        }
+        lru.emplace_front(t, std::move(v));
+        index.emplace(t, lru.begin());
+        if ((capacity > 0) && (lru.size() > capacity)) {
+            index.erase(lru.back().first);
+            lru.pop_back();
+            evictions++;
+        }
+    }
+
+    /**
+     * Removing a term from the cache, e.g., when the rules it was evaluated with have changed
+     * @param t     Term
+     * @return      Whether the term was cached
+     */
+    bool invalidate(const std::shared_ptr<Key>& t) {
+        auto it = index.find(t);
+        if (it == index.end())
+            return false;
+        lru.erase(it->second);
+        index.erase(it);
+        return true;
+    }
+
+    /**
+     * Removing all the cached terms, while preserving the counters
+     */
+    void clear() {
+        index.clear();
+        lru.clear();
+    }
+
+    std::size_t size() const { return lru.size(); }
+
+    std::size_t capacity;       ///< Maximum number of cached terms (zero if unbounded)
+    std::size_t hits = 0;       ///< Number of lookups finding the term
+    std::size_t misses = 0;     ///< Number of lookups not finding the term
+    std::size_t evictions = 0;  ///< Number of terms removed for exceeding the capacity
+
+private:
+    std::list<std::pair<std::shared_ptr<Key>, Value>> lru;  ///< Most recently used terms first
+    std::unordered_map<std::shared_ptr<Key>,
+            typename std::list<std::pair<std::shared_ptr<Key>, Value>>::iterator,
+            KeyHasher<Key>,
+            KeyEqualizer<Key>> index;
+};
+
+#endif //COTT_EVALUATION_CACHE_H
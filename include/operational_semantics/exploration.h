@@ -0,0 +1,197 @@
+/*
+ * exploration.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_EXPLORATION_H
+#define COTT_EXPLORATION_H
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <vector>
+
+/**
+ * Order in which the state space is visited
+ */
+enum class exploration_strategy {
+    depth_first,            ///< Depth-first, without any depth bound
+    breadth_first,          ///< Breadth-first, one layer of states at a time
+    depth_bounded,          ///< Depth-first, not expanding the states farther than max_depth from the start
+    iterative_deepening     ///< Depth-bounded searches with increasing bounds, up to max_depth if set
+};
+
+/**
+ * Why the exploration stopped
+ */
+enum class exploration_status {
+    completed,              ///< All the reachable states were expanded
+    depth_bound_reached,    ///< Some states were not expanded, as they lie at the depth bound
+    state_budget_exceeded,
+    edge_budget_exceeded,
+    time_budget_exceeded,
+    memory_budget_exceeded
+};
+
+inline const char* to_string(exploration_status status) {
+    switch (status) {
+        case exploration_status::completed:
+            return "completed";
+        case exploration_status::depth_bound_reached:
+            return "depth_bound_reached";
+        case exploration_status::state_budget_exceeded:
+            return "state_budget_exceeded";
+        case exploration_status::edge_budget_exceeded:
+            return "edge_budget_exceeded";
+        case exploration_status::time_budget_exceeded:
+            return "time_budget_exceeded";
+        case exploration_status::memory_budget_exceeded:
+            return "memory_budget_exceeded";
+    }
+    return "unknown";
+}
+
+/**
+ * How to explore the state space, and when to give up. Zero stands for no bound.
+ */
+struct exploration_options {
+    exploration_strategy strategy = exploration_strategy::depth_first;
+
+    /**
+     * Maximum distance from the start of the expanded states, for the breadth-first, depth-bounded, and iterative
+     * deepening strategies. The depth-first strategy ignores it
+     */
+    std::size_t max_depth = 0;
+
+    std::size_t max_states = 0;
+    std::size_t max_edges = 0;
+    std::chrono::milliseconds max_time{0};
+
+    /**
+     * Maximum memory in bytes, as estimated from the size of the visited states and of the graph
+     */
+    std::size_t max_memory = 0;
+};
+
+/**
+ * Partial-order reduction through ample sets: each state is expanded only through the transitions in one class of the
+ * dependency graph over its enabled transitions, provided that the class is not all of them, that none of its labels
+ * is visible, and that none of its targets was already visited. Otherwise, the state is fully expanded. This
+ * preserves the deadlocks, as well as the reachability of the visible labels.
+ *
+ * @tparam Node
+ * @tparam Label
+ */
+template <typename Node, typename Label>
+struct partial_order_reduction {
+    /**
+     * Whether the transitions state -l1-> t1 and state -l2-> t2 are independent. Besides commuting, a transition
+     * shall be independent of any transition that might be taken before it, from state, through the ones independent
+     * of it; e.g., they move distinct processes, one of which can never synchronise with the others. Not setting it
+     * disables the reduction
+     */
+    std::function<bool(const std::shared_ptr<Node>& state,
+                       const Label& l1, const std::shared_ptr<Node>& t1,
+                       const Label& l2, const std::shared_ptr<Node>& t2)> independent;
+
+    /**
+     * Labels whose reachability shall be preserved. If not set, none is visible, and only the deadlocks are preserved
+     */
+    std::function<bool(const Label&)> visible;
+
+    explicit operator bool() const {
+        return (bool)independent;
+    }
+};
+
+/**
+ * Callbacks notified while the graph is generated, e.g. for streaming it to a file. Either can be left unset.
+ */
+template <typename Node, typename Label>
+struct exploration_listener {
+    std::function<void(const std::shared_ptr<Node>&)> on_state;     ///< Each newly visited state, the start first
+
+    /**
+     * Each newly added edge, after its states were notified
+     */
+    std::function<void(const std::shared_ptr<Node>& src, const Label& label, const std::shared_ptr<Node>& dst)> on_edge;
+
+    /**
+     * As on_state, alongside the number of the state: its id in the store for visit_external, and otherwise the
+     * order in which it was first discovered, the start being 0. Numbering the states is left to the exploration, so
+     * that the listener does not need to retain them, e.g. when they are not kept in memory
+     */
+    std::function<void(std::size_t id, const std::shared_ptr<Node>&)> on_numbered_state;
+
+    /**
+     * As on_edge, between the numbers of the states
+     */
+    std::function<void(std::size_t src, const Label& label, std::size_t dst)> on_numbered_edge;
+};
+
+/**
+ * Outcome of an exploration. If it did not complete, the graph is the one generated so far: every expanded state
+ * comes with all of its edges, and every edge leads to a visited state.
+ */
+struct exploration_result {
+    exploration_status status = exploration_status::completed;
+    std::size_t states = 0;
+    std::size_t edges = 0;
+    std::size_t expansions = 0;     ///< Number of expanded states, including the re-expansions when depth-bounded
+    std::size_t pruned = 0;         ///< Transitions not taken, as pruned by the partial-order reduction
+    std::size_t depth = 0;          ///< Maximum distance from the start of a visited state, or the last bound
+    std::size_t memory = 0;         ///< Estimated memory in bytes
+    double elapsed_ms = 0.0;
+
+    bool completed() const {
+        return status == exploration_status::completed;
+    }
+};
+
+/**
+ * Path from the start of an exploration to a state: states[i+1] is reached from states[i] through labels[i]
+ */
+template <typename Node, typename Label>
+struct witness_trace {
+    std::vector<std::shared_ptr<Node>> states;
+    std::vector<Label> labels;
+
+    std::size_t length() const {
+        return labels.size();
+    }
+};
+
+/**
+ * Outcome of an on-the-fly query. The exploration status tells whether a budget or the depth bound stopped the search
+ * before finding a witness, in which case the answer is unknown
+ */
+template <typename Node, typename Label>
+struct query_result {
+    std::optional<witness_trace<Node, Label>> witness;
+    exploration_result exploration;
+
+    bool found() const {
+        return witness.has_value();
+    }
+};
+
+#endif //COTT_EXPLORATION_H
@@ -0,0 +1,183 @@
+/*
+ * hash_combine.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_HASH_COMBINE_H
+#define COTT_HASH_COMBINE_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+/**
+ * Finalizer of MurmurHash3, so that each bit of x affects all the bits of the result. Hashes are mixed before being
+ * combined, and before being used as an index, as std::hash is the identity over the integers and the pointers
+ */
+inline std::size_t hash_mix(std::size_t x) {
+    std::uint64_t h = x;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return (std::size_t)h;
+}
+
+/**
+ * Order-aware combination of a hash into a seed: combining the same hashes in a different order, or the same hash
+ * twice, gives a different result, unlike XOR or sums
+ */
+inline std::size_t hash_combine(std::size_t seed, std::size_t h) {
+    return hash_mix(seed ^ (h + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2)));
+}
+
+/**
+ * Hash of a sequence of values, depending on their order
+ */
+struct ordered_hash {
+    explicit ordered_hash(std::size_t seed = 0) : state{seed} {}
+
+    ordered_hash& add(std::size_t h) {
+        state = hash_combine(state, h);
+        return *this;
+    }
+
+    template <typename T>
+    ordered_hash& add_value(const T& x) {
+        return add(std::hash<T>()(x));
+    }
+
+    std::size_t value() const {
+        return state;
+    }
+
+private:
+    std::size_t state;
+};
+
+/**
+ * Hash of a multiset of values, independent of their order: each hash is mixed before being summed, so that equal
+ * elements do not cancel out and that the sum of distinct elements does not collide with other small sums
+ */
+struct multiset_hash {
+    explicit multiset_hash(std::size_t seed = 0) : seed{seed} {}
+
+    multiset_hash& add(std::size_t h) {
+        sum += hash_mix(h);
+        count++;
+        return *this;
+    }
+
+    template <typename T>
+    multiset_hash& add_value(const T& x) {
+        return add(std::hash<T>()(x));
+    }
+
+    std::size_t value() const {
+        return hash_combine(hash_combine(seed, sum), count);
+    }
+
+private:
+    std::size_t seed;
+    std::size_t sum = 0;
+    std::size_t count = 0;
+};
+
+/**
+ * Hash of a set of values, independent of their order and of their repetitions, for the types whose equality
+ * identifies duplicate elements. The hashes are collected, and the distinct ones are combined once sorted. Up to
+ * inline_capacity hashes are kept without allocating, as sets of children are usually small
+ */
+struct set_hash {
+    static constexpr std::size_t inline_capacity = 8;
+
+    explicit set_hash(std::size_t seed = 0) : seed{seed} {}
+
+    set_hash& add(std::size_t h) {
+        if (size < inline_capacity)
+            local[size] = h;
+        else {
+            if (size == inline_capacity)
+                spilled.assign(local.begin(), local.end());
+            spilled.emplace_back(h);
+        }
+        size++;
+        return *this;
+    }
+
+    template <typename T>
+    set_hash& add_value(const T& x) {
+        return add(std::hash<T>()(x));
+    }
+
+    std::size_t value() {
+        std::size_t* begin = (size <= inline_capacity) ? local.data() : spilled.data();
+        std::size_t* end = begin + size;
+        std::sort(begin, end);
+        ordered_hash result{seed};
+        for (auto it = begin; it != end; it = std::upper_bound(it, end, *it))
+            result.add(*it);
+        return result.value();
+    }
+
+private:
+    std::size_t seed;
+    std::size_t size = 0;
+    std::array<std::size_t, inline_capacity> local;
+    std::vector<std::size_t> spilled;
+};
+
+/**
+ * @return  Order-aware hash of the values, each hashed by std::hash
+ */
+template <typename... Ts>
+std::size_t hash_values(const Ts&... xs) {
+    ordered_hash result;
+    (result.add_value(xs), ...);
+    return result.value();
+}
+
+/**
+ * @return  Order-aware hash of a range, each element being hashed by hash
+ */
+template <typename Iterator, typename Hash = std::hash<typename std::iterator_traits<Iterator>::value_type>>
+std::size_t hash_range(Iterator begin, Iterator end, std::size_t seed = 0, Hash hash = {}) {
+    ordered_hash result{seed};
+    for (; begin != end; begin++)
+        result.add(hash(*begin));
+    return result.value();
+}
+
+/**
+ * @return  Order-insensitive hash of a range, viewed as a multiset, each element being hashed by hash
+ */
+template <typename Iterator, typename Hash = std::hash<typename std::iterator_traits<Iterator>::value_type>>
+std::size_t hash_unordered_range(Iterator begin, Iterator end, std::size_t seed = 0, Hash hash = {}) {
+    multiset_hash result{seed};
+    for (; begin != end; begin++)
+        result.add(hash(*begin));
+    return result.value();
+}
+
+#endif //COTT_HASH_COMBINE_H
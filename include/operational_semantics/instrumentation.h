@@ -0,0 +1,222 @@
+/*
+ * instrumentation.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_INSTRUMENTATION_H
+#define COTT_INSTRUMENTATION_H
+
+#include <operational_semantics/exploration.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+/**
+ * Whether the rules and the explorations collect their statistics, which is set by defining COTT_INSTRUMENTATION
+ * (e.g., via the COTT_INSTRUMENTATION CMake option). Otherwise, the statistics are never updated, and the code
+ * updating them is discarded at compile time.
+ */
+#ifdef COTT_INSTRUMENTATION
+inline constexpr bool instrumentation_enabled = true;
+#else
+inline constexpr bool instrumentation_enabled = false;
+#endif
+
+/**
+ * Histogram of latencies in nanoseconds, over buckets of exponentially increasing width: the i-th bucket counts the
+ * latencies in [2^(i-1), 2^i)
+ */
+struct latency_histogram {
+    static constexpr std::size_t buckets = 40;
+
+    std::array<std::uint64_t, buckets> counts{};
+    std::uint64_t count = 0;
+    std::uint64_t total_ns = 0;
+    std::uint64_t max_ns = 0;
+
+    void record(std::uint64_t ns) {
+        counts[std::min<std::size_t>(std::bit_width(ns), buckets - 1)]++;
+        count++;
+        total_ns += ns;
+        max_ns = std::max(max_ns, ns);
+    }
+
+    double mean_ns() const {
+        return count ? (double)total_ns / (double)count : 0.0;
+    }
+
+    /**
+     * @return  Upper bound of the bucket holding the q-quantile of the latencies
+     */
+    std::uint64_t quantile_ns(double q) const {
+        auto rank = (std::uint64_t)(q * (double)count);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i<buckets; i++) {
+            seen += counts[i];
+            if (seen > rank)
+                return std::min(max_ns, (std::uint64_t(1) << i) - 1);
+        }
+        return max_ns;
+    }
+
+    void write_json(std::ostream& os) const {
+        os << "{\"count\":" << count << ",\"mean_ns\":" << mean_ns() << ",\"p50_ns\":" << quantile_ns(0.5)
+           << ",\"p99_ns\":" << quantile_ns(0.99) << ",\"max_ns\":" << max_ns << ",\"buckets\":[";
+        std::size_t last = buckets;
+        while ((last > 0) && !counts[last - 1])
+            last--;
+        for (std::size_t i = 0; i<last; i++)
+            os << (i ? "," : "") << counts[i];
+        os << "]}";
+    }
+};
+
+/**
+ * Allocations performed by the current thread through operator new. These are only counted when the program links
+ * src/instrumentation_allocator.cpp (the operational_semantics_allocator CMake target), which replaces the global
+ * operator new and delete
+ */
+struct allocation_counters {
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;
+
+    static allocation_counters& local() {
+        thread_local allocation_counters counters;
+        return counters;
+    }
+};
+
+/**
+ * Measuring the time and the allocations of a scope
+ */
+struct instrumented_scope {
+    instrumented_scope() : allocations{allocation_counters::local()}, begin{std::chrono::steady_clock::now()} {}
+
+    std::uint64_t elapsed_ns() const {
+        return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    }
+
+    allocation_counters allocated() const {
+        const auto& now = allocation_counters::local();
+        return {now.count - allocations.count, now.bytes - allocations.bytes};
+    }
+
+private:
+    allocation_counters allocations;
+    std::chrono::steady_clock::time_point begin;
+};
+
+/**
+ * Statistics of a rule, where the latencies and the allocations of each application include its nested evaluations,
+ * as well as the consumption of the successors emitted by an emitting rule
+ */
+struct rule_statistics {
+    std::uint64_t tested = 0;       ///< Number of times its test was evaluated
+    std::uint64_t matched = 0;      ///< Number of times its test held, and thus it was applied
+    std::uint64_t successors = 0;
+    std::uint64_t allocations = 0;
+    std::uint64_t allocated_bytes = 0;
+    latency_histogram latency;
+
+    void write_json(std::ostream& os) const {
+        os << "{\"tested\":" << tested << ",\"matched\":" << matched << ",\"successors\":" << successors
+           << ",\"allocations\":" << allocations << ",\"allocated_bytes\":" << allocated_bytes << ",\"latency\":";
+        latency.write_json(os);
+        os << "}";
+    }
+};
+
+/**
+ * Statistics of the rules of a semantics, indexed by their priority
+ */
+struct semantics_statistics {
+    std::vector<rule_statistics> rules;
+    std::uint64_t evaluations = 0;      ///< Number of terms evaluated, excluding the ones answered by the memoization
+    std::uint64_t unmatched = 0;        ///< Number of terms to which no rule applied
+
+    void write_json(std::ostream& os) const {
+        os << "{\"enabled\":" << (instrumentation_enabled ? "true" : "false") << ",\"evaluations\":" << evaluations
+           << ",\"unmatched\":" << unmatched << ",\"rules\":[";
+        for (std::size_t i = 0; i<rules.size(); i++) {
+            os << (i ? "," : "");
+            rules[i].write_json(os);
+        }
+        os << "]}";
+    }
+
+    void clear() {
+        for (auto& rule : rules)
+            rule = {};
+        evaluations = unmatched = 0;
+    }
+};
+
+/**
+ * Progress of an exploration
+ */
+struct exploration_progress {
+    std::size_t states = 0;
+    std::size_t edges = 0;
+    std::size_t expansions = 0;
+    std::size_t frontier = 0;       ///< Visited states still to be expanded
+    std::size_t duplicates = 0;     ///< Successors that were already visited
+    std::size_t depth = 0;
+    double elapsed_ms = 0.0;
+
+    double states_per_second() const {
+        return elapsed_ms > 0.0 ? 1000.0 * (double)states / elapsed_ms : 0.0;
+    }
+
+    void write_json(std::ostream& os) const {
+        os << "{\"states\":" << states << ",\"edges\":" << edges << ",\"expansions\":" << expansions
+           << ",\"frontier\":" << frontier << ",\"duplicates\":" << duplicates << ",\"depth\":" << depth
+           << ",\"elapsed_ms\":" << elapsed_ms << ",\"states_per_second\":" << states_per_second() << "}";
+    }
+};
+
+/**
+ * Telemetry of the explorations of small_step_semantics, which is only collected when the instrumentation is enabled
+ */
+struct exploration_telemetry {
+    /**
+     * Called periodically while exploring, if set
+     */
+    std::function<void(const exploration_progress&)> on_progress;
+    std::chrono::milliseconds every{1000};
+
+    /**
+     * When set, where the JSON summary of each exploration is written when it ends
+     */
+    std::filesystem::path summary;
+
+    exploration_result result;          ///< Of the last exploration
+    exploration_progress progress;      ///< Of the last exploration, when it ended
+    std::size_t max_frontier = 0;
+    allocation_counters allocations;    ///< Performed by the last exploration
+};
+
+#endif //COTT_INSTRUMENTATION_H
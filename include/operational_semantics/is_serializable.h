@@ -0,0 +1,133 @@
+/*
+ * is_serializable.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef OPERATIONAL_SEMANTICS_IS_SERIALIZABLE_H
+#define OPERATIONAL_SEMANTICS_IS_SERIALIZABLE_H
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Describing how to write a value as bytes, appended to a string, and how to read it back from a pointer to its
+ * bytes, which is then moved past them. Specialising this for a type, by providing
+ *
+ *      static void write(const T& x, std::string& out);
+ *      static T read(const char*& in);
+ *
+ * makes it serializable. The arithmetic and enumeration types, the strings, and the pairs, vectors and shared
+ * pointers of serializable types are serializable.
+ * @tparam T
+ */
+template <typename T, typename = void>
+struct serialization_traits {};
+
+template <typename T, typename = std::void_t<>>
+struct is_serializable : std::false_type { };
+
+template <typename T>
+struct is_serializable<T, std::void_t<decltype(serialization_traits<T>::write(std::declval<const T&>(), std::declval<std::string&>())),
+                                      decltype(serialization_traits<T>::read(std::declval<const char*&>()))>> : std::true_type { };
+
+template <typename T>
+constexpr bool is_serializable_v = is_serializable<T>::value;
+
+template <typename T>
+struct serialization_traits<T, std::enable_if_t<std::is_arithmetic_v<T> || std::is_enum_v<T>>> {
+    static void write(const T& x, std::string& out) {
+        out.append(reinterpret_cast<const char*>(&x), sizeof(T));
+    }
+
+    static T read(const char*& in) {
+        T x;
+        std::memcpy(&x, in, sizeof(T));
+        in += sizeof(T);
+        return x;
+    }
+};
+
+template <>
+struct serialization_traits<std::string> {
+    static void write(const std::string& x, std::string& out) {
+        serialization_traits<std::size_t>::write(x.size(), out);
+        out.append(x);
+    }
+
+    static std::string read(const char*& in) {
+        auto size = serialization_traits<std::size_t>::read(in);
+        std::string x{in, size};
+        in += size;
+        return x;
+    }
+};
+
+template <typename K, typename V>
+struct serialization_traits<std::pair<K, V>, std::enable_if_t<is_serializable_v<K> && is_serializable_v<V>>> {
+    static void write(const std::pair<K, V>& x, std::string& out) {
+        serialization_traits<K>::write(x.first, out);
+        serialization_traits<V>::write(x.second, out);
+    }
+
+    static std::pair<K, V> read(const char*& in) {
+        auto first = serialization_traits<K>::read(in);
+        return {std::move(first), serialization_traits<V>::read(in)};
+    }
+};
+
+template <typename T>
+struct serialization_traits<std::vector<T>, std::enable_if_t<is_serializable_v<T>>> {
+    static void write(const std::vector<T>& x, std::string& out) {
+        serialization_traits<std::size_t>::write(x.size(), out);
+        for (const auto& e : x)
+            serialization_traits<T>::write(e, out);
+    }
+
+    static std::vector<T> read(const char*& in) {
+        std::vector<T> x(serialization_traits<std::size_t>::read(in));
+        for (auto& e : x)
+            e = serialization_traits<T>::read(in);
+        return x;
+    }
+};
+
+/**
+ * Shared pointers are written as their pointed value, so that the sharing is not preserved
+ */
+template <typename T>
+struct serialization_traits<std::shared_ptr<T>, std::enable_if_t<is_serializable_v<T>>> {
+    static void write(const std::shared_ptr<T>& x, std::string& out) {
+        serialization_traits<bool>::write((bool)x, out);
+        if (x)
+            serialization_traits<T>::write(*x, out);
+    }
+
+    static std::shared_ptr<T> read(const char*& in) {
+        if (!serialization_traits<bool>::read(in))
+            return nullptr;
+        return std::make_shared<T>(serialization_traits<T>::read(in));
+    }
+};
+
+#endif //OPERATIONAL_SEMANTICS_IS_SERIALIZABLE_H
@@ -0,0 +1,99 @@
+/*
+ * key_hasher.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_KEY_HASHER_H
+#define COTT_KEY_HASHER_H
+
+#include <operational_semantics/has_equality.h>
+#include <operational_semantics/is_hashable.h>
+#include <operational_semantics/hash_combine.h>
+#include <operational_semantics/structural_equality.h>
+#include <memory>
+
+/**
+ * Default hasher for a smart-pointer, by exploiting the hash value associated to the pointed object, which is mixed so
+ * that weak hashes (e.g., small integers, or XORs of the children's hashes) are still spread over all the buckets
+ * @tparam Key
+ */
+template <typename Key>
+struct KeyHasher
+{
+    static_assert(is_std_hashable_v<Key>, "Error: the key should be hashable");
+
+    std::size_t operator()(const std::shared_ptr<Key>& k) const
+    {
+        using std::size_t;
+        using std::hash;
+        using std::string;
+        if (!k) {
+            return 0;
+        } else {
+            return hash_mix(hash<Key>()(*k.get()) * 2 +1);
+        }
+    }
+};
+
+/**
+ * Default smart pointer comparator, also encompassing whether the pointer is pointing to null. The same pointer is
+ * equal to itself, and keys caching their hash (see cached_hash) are told apart by it, so that the structural equality
+ * is only called over the keys that are likely equal
+ * @tparam Key
+ */
+template <typename Key>
+struct KeyEqualizer
+{
+    static_assert(CHECK::EqualExists<Key>::value, "Error: the key should come with a default equality predicate");
+
+    bool operator()(const std::shared_ptr<Key>& __x, const std::shared_ptr<Key>& __y) const
+    {
+        if (__x.get() == __y.get())
+            return true;
+        if ((!__x) || (!__y))
+            return false;
+        if constexpr (has_hash_cache_v<Key>)
+            if (!__x->hash_cache.may_equal(__y->hash_cache))
+                return false;
+        return *__x == *__y;
+    }
+
+};
+
+/**
+ * Keys for storing terms by their structure, through the default hasher and comparator
+ * @tparam Node
+ */
+template <typename Node>
+struct structural_keys {
+    using hasher = KeyHasher<Node>;
+    using equalizer = KeyEqualizer<Node>;
+
+    /**
+     * @return  The term itself, as it can be already stored by its structure
+     */
+    const std::shared_ptr<Node>& canonical(const std::shared_ptr<Node>& t) {
+        return t;
+    }
+
+    void clear() {}
+};
+
+#endif //COTT_KEY_HASHER_H
@@ -29,8 +29,23 @@
 
 #include <operational_semantics/has_equality.h>
 #include <operational_semantics/is_hashable.h>
+#include <operational_semantics/evaluation_cache.h>
+#include <operational_semantics/instrumentation.h>
 #include <memory>
 #include <functional>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#if __has_include(<ucontext.h>) && __has_include(<sys/mman.h>)
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#define COTT_HAS_UCONTEXT
+#endif
 
 template <typename InputType,
         typename TransitionType,
@@ -53,6 +68,119 @@ std::function<bool(const std::shared_ptr<InputType>& t)>,
 std::function<std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>>(Rec*, const std::shared_ptr<InputType>& t)>>;
 
 
+/**
+ * Limits for the evaluation of the terms
+ */
+struct evaluation_limits {
+    /**
+     * Maximum number of nested rule applications on each stack segment. When exceeded, the nested evaluation continues
+     * on a new stack segment allocated on the heap, thus allowing the evaluation of terms of any depth. Zero stands for
+     * the plain recursive evaluation on the caller's stack. Stack segments require ucontext (POSIX).
+     */
+    std::size_t native_depth = 0;
+
+    /**
+     * Size in bytes of each newly allocated stack segment, which is raised to fit native_depth nested rule
+     * applications of frame_size bytes each. Overrunning a segment faults on the guard page below it, rather than
+     * overwriting the neighbouring memory
+     */
+    std::size_t segment_size = 1 << 20;
+
+    /**
+     * Estimated stack bytes used by each nested rule application, including the rule's own frame
+     */
+    std::size_t frame_size = 1024;
+
+    /**
+     * @return  Size in bytes of the stack segments, excluding their guard page
+     */
+    std::size_t segment_bytes() const {
+        return std::max(segment_size, native_depth * frame_size);
+    }
+
+    /**
+     * Maximum depth of the nested evaluations (zero if unbounded): deeper terms are considered as ill-formed, and
+     * therefore evaluate to an empty vector
+     */
+    std::size_t max_depth = 0;
+};
+
+#ifdef COTT_HAS_UCONTEXT
+/**
+ * Stack segment mapped from the operating system, with an inaccessible guard page below it, so that a stack overflow
+ * faults instead of silently overwriting other memory
+ */
+struct guarded_stack {
+    explicit guarded_stack(std::size_t bytes) {
+        std::size_t page = (std::size_t)sysconf(_SC_PAGESIZE);
+        size = (bytes + page - 1) / page * page;
+        mapped = size + page;
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_STACK
+        flags |= MAP_STACK;
+#endif
+        void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+        // The stacks grow downwards, so the guard page is the lowest one
+        if (mprotect(p, page, PROT_NONE) != 0) {
+            munmap(p, mapped);
+            throw std::bad_alloc();
+        }
+        base = (char*)p;
+        stack = base + page;
+    }
+
+    guarded_stack(const guarded_stack&) = delete;
+    guarded_stack& operator=(const guarded_stack&) = delete;
+
+    ~guarded_stack() {
+        munmap(base, mapped);
+    }
+
+    char* stack;            ///< Lowest usable address
+    std::size_t size;       ///< Usable bytes, above the guard page
+
+private:
+    char* base;
+    std::size_t mapped;
+};
+#endif
+
+/**
+ * Statistics collected when evaluating with some limit, accumulated across the evaluations
+ */
+struct evaluation_statistics {
+    std::size_t max_depth = 0;          ///< Maximum depth of the nested evaluations
+    std::size_t max_segments = 0;       ///< Maximum number of heap-allocated stack segments in use at once
+    std::size_t segment_switches = 0;   ///< Number of nested evaluations moved to a new stack segment
+    std::size_t segment_bytes = 0;      ///< Bytes currently allocated for the stack segments
+    bool depth_exceeded = false;        ///< Whether some term was deeper than the maximum depth
+};
+
+/**
+ * Non-owning callback receiving the successors emitted by a rule, one at a time, so that these can be consumed
+ * without collecting them into a vector. A sink shall not be retained after the call it was passed to.
+ * @tparam TransitionType
+ * @tparam ResultType
+ */
+template <typename TransitionType,
+        typename ResultType>
+struct successor_sink {
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::remove_cvref_t<F>, successor_sink>>>
+    successor_sink(F&& f) : object{(void*)std::addressof(f)},
+                            call{[](void* o, const TransitionType& label, const std::shared_ptr<ResultType>& result) {
+                                (*static_cast<std::remove_reference_t<F>*>(o))(label, result);
+                            }} {}
+
+    void operator()(const TransitionType& label, const std::shared_ptr<ResultType>& result) const {
+        call(object, label, result);
+    }
+
+private:
+    void* object;
+    void (*call)(void*, const TransitionType&, const std::shared_ptr<ResultType>&);
+};
 
 template <typename InputType,
         typename TransitionType,
@@ -60,7 +188,8 @@ template <typename InputType,
 struct language_semantics : public std::function<std::vector<std::pair<std::string,std::shared_ptr<ResultType>>>(const std::shared_ptr<InputType>&)> {
 
 /**
- * Adding a rule to be evaluated. These are considered by decreasing priority, depending on the insertion order
+ * Adding a rule to be evaluated. These are considered by decreasing priority, depending on the insertion order.
+ * As the new rule might change the evaluation of any term, the memoized evaluations are discarded
  * @param f1    Testing condition, for checking whether the current case is applicable to the current rule (preliminary entry-point)
  * @param f2    Expression for determinign the rewriting: if not viable, an empty expression is returend
  */
@@ -68,6 +197,127 @@ void add_rule(const std::function<bool(const std::shared_ptr<InputType>& )>& f1,
               //std::vector<std::pair<std::pair<bool,std::string>,std::shared_ptr<finite_ccs>>>
               const std::function<std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>>(language_semantics<InputType,TransitionType,ResultType>*, const std::shared_ptr<InputType>& t)>& f2) {
 rules_by_priority.emplace_back(f1, f2);
+rule_keys.emplace_back(std::nullopt);
+rule_emitters.emplace_back();
+profile.rules.emplace_back();
+index_rule(rules_by_priority.size()-1);
+invalidate();
+}
+
+/**
+ * Adding a rule that only applies to the terms whose discriminator evaluates to key (e.g., the inductive case of
+ * the term). When a discriminator is set, the rule is only tested against such terms; otherwise, the key is ignored
+ * and the rule is scanned as any other rule. Therefore, the test f1 should never hold for terms having a different key,
+ * so that both dispatch modes return the same result.
+ * @param key   Discriminator value associated to the rule
+ * @param f1    Testing condition, for checking whether the current case is applicable to the current rule (preliminary entry-point)
+ * @param f2    Expression for determinign the rewriting: if not viable, an empty expression is returend
+ */
+void add_rule(std::size_t key,
+              const std::function<bool(const std::shared_ptr<InputType>& )>& f1,
+              const std::function<std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>>(language_semantics<InputType,TransitionType,ResultType>*, const std::shared_ptr<InputType>& t)>& f2) {
+    rules_by_priority.emplace_back(f1, f2);
+    rule_keys.emplace_back(key);
+    rule_emitters.emplace_back();
+    profile.rules.emplace_back();
+    index_rule(rules_by_priority.size()-1);
+    invalidate();
+}
+
+/**
+ * Adding a rule that pushes its successors into a sink rather than returning them, so that no intermediate vector
+ * is required when streaming the successors through emit. These rules are considered by decreasing priority
+ * together with the ones returning a vector
+ * @param f1    Testing condition, for checking whether the current case is applicable to the current rule (preliminary entry-point)
+ * @param f2    Expression for determining the rewriting, emitting each successor alongside its transition
+ */
+void add_emitting_rule(const std::function<bool(const std::shared_ptr<InputType>& )>& f1,
+                       const std::function<void(language_semantics<InputType,TransitionType,ResultType>*, const std::shared_ptr<InputType>& t, successor_sink<TransitionType,ResultType> out)>& f2) {
+    rules_by_priority.emplace_back(f1, nullptr);
+    rule_keys.emplace_back(std::nullopt);
+    rule_emitters.emplace_back(f2);
+    profile.rules.emplace_back();
+    index_rule(rules_by_priority.size()-1);
+    invalidate();
+}
+
+/**
+ * Adding an emitting rule that only applies to the terms whose discriminator evaluates to key
+ * @param key   Discriminator value associated to the rule
+ * @param f1    Testing condition, for checking whether the current case is applicable to the current rule (preliminary entry-point)
+ * @param f2    Expression for determining the rewriting, emitting each successor alongside its transition
+ */
+void add_emitting_rule(std::size_t key,
+                       const std::function<bool(const std::shared_ptr<InputType>& )>& f1,
+                       const std::function<void(language_semantics<InputType,TransitionType,ResultType>*, const std::shared_ptr<InputType>& t, successor_sink<TransitionType,ResultType> out)>& f2) {
+    rules_by_priority.emplace_back(f1, nullptr);
+    rule_keys.emplace_back(key);
+    rule_emitters.emplace_back(f2);
+    profile.rules.emplace_back();
+    index_rule(rules_by_priority.size()-1);
+    invalidate();
+}
+
+/**
+ * Enabling the indexed dispatch: the rules are no longer scanned linearly, but only the ones registered with the
+ * discriminator value of the current term (plus the ones registered without a key) are tested, still by decreasing
+ * priority. Keys below max_dense_key (e.g., an enumeration) are looked up in a jump table, while the larger ones
+ * (e.g., hashes, or enumerations with gaps) in a hash map, so that the table never grows beyond max_dense_key
+ * buckets. Any value that was never used for registering a rule only tests the rules without a key.
+ * The indexing only pays off with many rules: with the few ones of the examples, the linear scan is as fast, and even
+ * faster for finite CCS, as the discriminator call costs as much as the tests it skips (see rule_dispatch_bench).
+ * @param f     Key extractor (e.g., the inductive case of the term). Passing an empty function restores the linear scan
+ */
+void set_discriminator(std::function<std::size_t(const std::shared_ptr<InputType>&)> f) {
+    discriminator = std::move(f);
+    jump_table.clear();
+    sparse_table.clear();
+    wildcard_rules.clear();
+    for (std::size_t i = 0, N = rules_by_priority.size(); i<N; i++)
+        index_rule(i);
+}
+
+/**
+ * Enabling the memoization of the evaluations, so that terms that are structurally equivalent to an already
+ * evaluated one (e.g., shared sub-terms) are no further evaluated. This requires that the input type is hashable
+ * and comes with an equality predicate, and that the rules are deterministic.
+ * @param capacity  Maximum number of memoized terms, where zero stands for an unbounded cache
+ */
+void enable_memoization(std::size_t capacity = 0) {
+    memo = std::make_shared<evaluation_cache<InputType, std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>>>>(capacity);
+}
+
+/**
+ * Disabling the memoization, and discarding all the memoized evaluations
+ */
+void disable_memoization() {
+    memo.reset();
+}
+
+/**
+ * @return  Memoization table, from which retrieving the hit/miss counters, or null if memoization is not enabled
+ */
+const std::shared_ptr<evaluation_cache<InputType, std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>>>>& memoization() const {
+    return memo;
+}
+
+/**
+ * Discarding the memoized evaluation for a given term
+ * @param t     Term to be evaluated again at the next call
+ */
+void invalidate(const std::shared_ptr<InputType>& t) {
+    if constexpr (is_std_hashable_v<InputType> && CHECK::EqualExists<InputType>::value) {
+        if (memo) memo->invalidate(t);
+    }
+}
+
+/**
+ * Discarding all the memoized evaluations, which is done whenever a rule is added
+ */
+void invalidate() {
+    if constexpr (is_std_hashable_v<InputType> && CHECK::EqualExists<InputType>::value) {
+        if (memo) memo->clear();
+    }
 }
 
 /**
@@ -78,16 +328,299 @@ rules_by_priority.emplace_back(f1, f2);
  *              applied, and therefore the vector will be empty
  */
 std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> operator()(const std::shared_ptr<InputType>& t) {
-    for (const auto& [test, transform] : rules_by_priority) {
-        if (test(t)) {
-            return transform(this, t);
-        }
+    if ((limits.native_depth == 0) && (limits.max_depth == 0))
+        return evaluate(t);
+    return evaluate_within_limits(t);
+}
+
+/**
+ * Streaming the evaluation of a term into a sink, which receives the same results of operator(), in the same order.
+ * Rules returning a vector are adapted by pushing each of their results, while the memoized evaluations and the ones
+ * within limits are first collected.
+ * @param t     Term to be evaluated
+ * @param out   Sink receiving each result alongside its transition
+ */
+void emit(const std::shared_ptr<InputType>& t, successor_sink<TransitionType,ResultType> out) {
+    if (memo || (limits.native_depth > 0) || (limits.max_depth > 0)) {
+        for (const auto& [label, result] : operator()(t))
+            out(label, result);
+        return;
     }
-    return {};
+    std::size_t i = matching_rule(t);
+    if (i == no_rule)
+        return;
+    if constexpr (instrumentation_enabled) {
+        instrumented_scope scope;
+        std::uint64_t successors = 0;
+        apply_rule(i, t, [&successors, &out](const TransitionType& label, const std::shared_ptr<ResultType>& result) {
+            successors++;
+            out(label, result);
+        });
+        record(i, scope, successors);
+    } else
+        apply_rule(i, t, out);
 }
 
+/**
+ * Limits for the evaluation. When the native depth is set, the nested evaluations are spread across stack segments
+ * allocated on the heap, which are retained for the next evaluations
+ */
+evaluation_limits limits;
+
+/**
+ * Statistics of the evaluations within the limits
+ */
+evaluation_statistics statistics;
+
+/**
+ * Per-rule counters, latencies and allocations, which are only collected when the instrumentation is enabled
+ */
+semantics_statistics profile;
+
 private:
 std::vector<semantics_rule<InputType,TransitionType,ResultType,language_semantics<InputType,TransitionType,ResultType>>> rules_by_priority;
+std::vector<std::optional<std::size_t>> rule_keys;
+std::vector<std::function<void(language_semantics<InputType,TransitionType,ResultType>*, const std::shared_ptr<InputType>&, successor_sink<TransitionType,ResultType>)>> rule_emitters;   ///< For the emitting rules
+
+std::function<std::size_t(const std::shared_ptr<InputType>&)> discriminator;
+std::vector<std::vector<std::size_t>> jump_table;   ///< For each key, the rules to be tested by decreasing priority
+std::unordered_map<std::size_t, std::vector<std::size_t>> sparse_table;     ///< As jump_table, for the keys from max_dense_key
+std::vector<std::size_t> wildcard_rules;            ///< Rules without a key, tested for any key
+std::shared_ptr<evaluation_cache<InputType, std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>>>> memo;
+
+std::size_t depth = 0;          ///< Depth of the current nested evaluation
+std::size_t segment_depth = 0;  ///< Nested rule applications on the current stack segment
+
+/**
+ * Restoring a counter when leaving the scope, also on exceptions
+ */
+struct restore_on_exit {
+    std::size_t& counter;
+    std::size_t value;
+    ~restore_on_exit() { counter = value; }
+};
+
+/**
+ * Evaluating a nested term while keeping track of its depth, and switching to a new stack segment if required
+ */
+std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> evaluate_within_limits(const std::shared_ptr<InputType>& t) {
+    restore_on_exit restore_depth{depth, depth};
+    depth++;
+    statistics.max_depth = std::max(statistics.max_depth, depth);
+    if ((limits.max_depth > 0) && (depth > limits.max_depth)) {
+        statistics.depth_exceeded = true;
+        return {};
+    }
+#ifdef COTT_HAS_UCONTEXT
+    if ((limits.native_depth > 0) && (segment_depth >= limits.native_depth))
+        return evaluate_on_new_segment(t);
+#endif
+    restore_on_exit restore_segment_depth{segment_depth, segment_depth};
+    segment_depth++;
+    return evaluate(t);
+}
+
+#ifdef COTT_HAS_UCONTEXT
+/**
+ * Evaluation to be run on a new stack segment
+ */
+struct segment_call {
+    language_semantics* self;
+    const std::shared_ptr<InputType>* term;
+    std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> result;
+    std::exception_ptr error;
+    ucontext_t caller;
+    ucontext_t callee;
+};
+
+static inline thread_local segment_call* starting_segment_call = nullptr;
+
+/**
+ * Stack segments, reused by nesting level. These are never shared among copies
+ */
+struct stack_segments : public std::vector<std::unique_ptr<guarded_stack>> {
+    stack_segments() = default;
+    stack_segments(const stack_segments&) {}
+    stack_segments& operator=(const stack_segments&) { return *this; }
+} segments;
+std::size_t segments_in_use = 0;
+
+/**
+ * Entry point of a new stack segment: the exceptions are moved back to the caller's segment, as they cannot be
+ * propagated across segments
+ */
+static void run_segment() {
+    segment_call* call = starting_segment_call;
+    try {
+        call->self->segment_depth = 1;
+        call->result = call->self->evaluate(*call->term);
+    } catch (...) {
+        call->error = std::current_exception();
+    }
+}
+
+std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> evaluate_on_new_segment(const std::shared_ptr<InputType>& t) {
+    std::size_t bytes = limits.segment_bytes();
+    if (segments_in_use == segments.size())
+        segments.emplace_back();
+    // Segments allocated under smaller limits are replaced
+    auto& segment = segments[segments_in_use];
+    if ((!segment) || (segment->size < bytes)) {
+        if (segment)
+            statistics.segment_bytes -= segment->size;
+        segment = std::make_unique<guarded_stack>(bytes);
+        statistics.segment_bytes += segment->size;
+    }
+    restore_on_exit restore_segment_depth{segment_depth, segment_depth};
+    restore_on_exit restore_segments{segments_in_use, segments_in_use};
+    segment_call call{this, &t, {}, {}, {}, {}};
+    getcontext(&call.callee);
+    call.callee.uc_stack.ss_sp = segment->stack;
+    call.callee.uc_stack.ss_size = segment->size;
+    segments_in_use++;
+    call.callee.uc_link = &call.caller;
+    makecontext(&call.callee, &run_segment, 0);
+    statistics.segment_switches++;
+    statistics.max_segments = std::max(statistics.max_segments, segments_in_use);
+    starting_segment_call = &call;
+    swapcontext(&call.caller, &call.callee);
+    if (call.error)
+        std::rethrow_exception(call.error);
+    return std::move(call.result);
+}
+#endif
+
+/**
+ * Evaluating a term, possibly from the memoization table
+ */
+std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> evaluate(const std::shared_ptr<InputType>& t) {
+    if constexpr (is_std_hashable_v<InputType> && CHECK::EqualExists<InputType>::value) {
+        if (memo) {
+            if (const auto* cached = memo->find(t))
+                return *cached;
+            auto result = apply_rules(t);
+            memo->insert(t, result);
+            return result;
+        }
+    }
+    return apply_rules(t);
+}
+
+static constexpr std::size_t no_rule = std::numeric_limits<std::size_t>::max();
+
+/**
+ * Keys from this value on are indexed by a hash map rather than by the jump table
+ */
+static constexpr std::size_t max_dense_key = 1024;
+
+/**
+ * @return  The first rule whose test holds by decreasing priority, and no_rule if none
+ */
+std::size_t matching_rule(const std::shared_ptr<InputType>& t) {
+    if constexpr (instrumentation_enabled)
+        profile.evaluations++;
+    if (discriminator) {
+        std::size_t key = discriminator(t);
+        const auto& bucket = (key < jump_table.size()) ? jump_table[key] : sparse_bucket(key);
+        for (std::size_t i : bucket) {
+            if (test_rule(i, t))
+                return i;
+        }
+    } else {
+        for (std::size_t i = 0, N = rules_by_priority.size(); i<N; i++) {
+            if (test_rule(i, t))
+                return i;
+        }
+    }
+    if constexpr (instrumentation_enabled)
+        profile.unmatched++;
+    return no_rule;
+}
+
+bool test_rule(std::size_t i, const std::shared_ptr<InputType>& t) {
+    if constexpr (instrumentation_enabled)
+        profile.rules[i].tested++;
+    return rules_by_priority[i].first(t);
+}
+
+/**
+ * Applying the first rule whose test holds, by decreasing priority
+ */
+std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> apply_rules(const std::shared_ptr<InputType>& t) {
+    std::size_t i = matching_rule(t);
+    if (i == no_rule)
+        return {};
+    if constexpr (instrumentation_enabled) {
+        instrumented_scope scope;
+        auto result = apply_rule(i, t);
+        record(i, scope, result.size());
+        return result;
+    } else
+        return apply_rule(i, t);
+}
+
+std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> apply_rule(std::size_t i, const std::shared_ptr<InputType>& t) {
+    if (!rule_emitters[i])
+        return rules_by_priority[i].second(this, t);
+    std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> result;
+    rule_emitters[i](this, t, [&result](const TransitionType& label, const std::shared_ptr<ResultType>& r) {
+        result.emplace_back(label, r);
+    });
+    return result;
+}
+
+void apply_rule(std::size_t i, const std::shared_ptr<InputType>& t, successor_sink<TransitionType,ResultType> out) {
+    if (rule_emitters[i])
+        rule_emitters[i](this, t, out);
+    else
+        for (const auto& [label, result] : rules_by_priority[i].second(this, t))
+            out(label, result);
+}
+
+/**
+ * Recording an application of the i-th rule, measured by scope
+ */
+void record(std::size_t i, const instrumented_scope& scope, std::uint64_t successors) {
+    auto& rule = profile.rules[i];
+    rule.latency.record(scope.elapsed_ns());
+    auto allocated = scope.allocated();
+    rule.allocations += allocated.count;
+    rule.allocated_bytes += allocated.bytes;
+    rule.matched++;
+    rule.successors += successors;
+}
+
+/**
+ * Adding the i-th rule to the jump table. As rules are indexed by increasing insertion order, each bucket
+ * preserves the priority order among the rules
+ */
+void index_rule(std::size_t i) {
+    if (!discriminator) return;
+    const auto& key = rule_keys[i];
+    if (!key) {
+        wildcard_rules.emplace_back(i);
+        for (auto& bucket : jump_table)
+            bucket.emplace_back(i);
+        for (auto& [k, bucket] : sparse_table)
+            bucket.emplace_back(i);
+    } else if (*key < max_dense_key) {
+        while (jump_table.size() <= *key)
+            jump_table.emplace_back(wildcard_rules);
+        jump_table[*key].emplace_back(i);
+    } else {
+        sparse_table.try_emplace(*key, wildcard_rules).first->second.emplace_back(i);
+    }
+}
+
+/**
+ * @return  The rules to be tested for a key not in the jump table
+ */
+const std::vector<std::size_t>& sparse_bucket(std::size_t key) const {
+    if (sparse_table.empty())
+        return wildcard_rules;
+    auto it = sparse_table.find(key);
+    return (it != sparse_table.end()) ? it->second : wildcard_rules;
+}
 
 };
 
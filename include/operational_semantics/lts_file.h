@@ -0,0 +1,411 @@
+/*
+ * lts_file.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_LTS_FILE_H
+#define COTT_LTS_FILE_H
+
+#include <operational_semantics/compact_lts.h>
+#include <operational_semantics/exploration.h>
+#include <operational_semantics/is_serializable.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Header of the binary LTS format. The file is made of this header, followed by the sections it points to, each
+ * aligned to 8 bytes:
+ *  - state table: states + 1 offsets into the state data, and the serialized states;
+ *  - label table: labels + 1 offsets into the label data, and the serialized labels;
+ *  - edges: states + 1 row offsets, and the edges of compact_lts, sorted by source, label and target.
+ * All the integers are stored in the native byte order, and the state 0 is the initial one.
+ */
+struct lts_file_header {
+    static constexpr char expected_magic[8] = {'C', 'O', 'T', 'T', 'L', 'T', 'S', '\0'};
+    static constexpr std::uint32_t current_version = 1;
+
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;       ///< 0x01020304, as written on the producing machine
+    std::uint64_t states;
+    std::uint64_t labels;
+    std::uint64_t edges;
+    std::uint64_t state_offsets;    ///< File position of each section
+    std::uint64_t state_data;
+    std::uint64_t label_offsets;
+    std::uint64_t label_data;
+    std::uint64_t row_offsets;
+    std::uint64_t edge_data;
+    std::uint64_t size;             ///< Size of the whole file
+};
+
+/**
+ * Writing a frozen LTS in the binary LTS format
+ */
+template <typename Node, typename Label, typename NodeKeys>
+void save_lts(const std::filesystem::path& path, const compact_lts<Node, Label, NodeKeys>& lts) {
+    static_assert(is_serializable_v<Node>, "Error: the node type should be serializable, so to be saved");
+    static_assert(is_serializable_v<Label>, "Error: the label type should be serializable, so to be saved");
+    using edge = typename compact_lts<Node, Label, NodeKeys>::edge;
+    std::string out(sizeof(lts_file_header), '\0');
+    auto align = [&out]() { out.resize((out.size() + 7) & ~std::size_t(7), '\0'); };
+    auto put = [&out](std::uint64_t x) { out.append(reinterpret_cast<const char*>(&x), sizeof(x)); };
+    // Writing count + 1 offsets, followed by the serialized values
+    auto table = [&](std::size_t count, auto&& serialize, std::uint64_t& offsets, std::uint64_t& data) {
+        std::string values;
+        std::vector<std::uint64_t> positions{0};
+        for (std::size_t i = 0; i<count; i++) {
+            serialize(i, values);
+            positions.emplace_back(values.size());
+        }
+        align();
+        offsets = out.size();
+        for (auto p : positions)
+            put(p);
+        data = out.size();
+        out.append(values);
+    };
+
+    lts_file_header header{};
+    std::memcpy(header.magic, lts_file_header::expected_magic, sizeof(header.magic));
+    header.version = lts_file_header::current_version;
+    header.byte_order = 0x01020304;
+    header.states = lts.state_count();
+    header.labels = lts.label_count();
+    header.edges = lts.edge_count();
+    table(lts.state_count(), [&lts](std::size_t i, std::string& values) {
+        serialization_traits<Node>::write(*lts.term((typename compact_lts<Node, Label, NodeKeys>::state_id)i), values);
+    }, header.state_offsets, header.state_data);
+    table(lts.label_count(), [&lts](std::size_t i, std::string& values) {
+        serialization_traits<Label>::write(lts.label((typename compact_lts<Node, Label, NodeKeys>::label_id)i), values);
+    }, header.label_offsets, header.label_data);
+    align();
+    header.row_offsets = out.size();
+    std::uint64_t row = 0;
+    put(row);
+    for (std::size_t s = 0; s<lts.state_count(); s++)
+        put(row += lts.successors((typename compact_lts<Node, Label, NodeKeys>::state_id)s).size());
+    header.edge_data = out.size();
+    for (std::size_t s = 0; s<lts.state_count(); s++)
+        for (const auto& e : lts.successors((typename compact_lts<Node, Label, NodeKeys>::state_id)s))
+            out.append(reinterpret_cast<const char*>(&e), sizeof(edge));
+    header.size = out.size();
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    std::ofstream file{path, std::ios::binary | std::ios::trunc};
+    if (!file.write(out.data(), (std::streamsize)out.size()))
+        throw std::system_error(errno, std::generic_category(), path.string());
+}
+
+/**
+ * Read-only view over an LTS saved by save_lts, which is memory-mapped without being parsed: the edges are accessed
+ * in place, while the states and the labels are deserialized only when requested. The layout is validated when the
+ * file is opened, i.e. that the sections and the serialized values lie within the file, that the rows are monotone,
+ * and that the edges lead to existing states through existing labels, so that the accessors read within the mapping
+ */
+template <typename Node, typename Label>
+struct mapped_lts {
+    using state_id = std::uint32_t;
+    using label_id = std::uint32_t;
+    using edge = typename compact_lts<Node, Label>::edge;
+
+    explicit mapped_lts(const std::filesystem::path& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::system_error(errno, std::generic_category(), path.string());
+        struct stat info{};
+        if (::fstat(fd, &info) < 0) {
+            ::close(fd);
+            throw std::system_error(errno, std::generic_category(), path.string());
+        }
+        length = (std::size_t)info.st_size;
+        void* region = (length > 0) ? ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (region == MAP_FAILED)
+            throw std::system_error(errno ? errno : EINVAL, std::generic_category(), path.string());
+        map = (const char*)region;
+        if ((length < sizeof(lts_file_header)) ||
+            (std::memcmp(header().magic, lts_file_header::expected_magic, sizeof(header().magic)) != 0) ||
+            (header().version != lts_file_header::current_version) || (header().byte_order != 0x01020304) ||
+            (header().size != length)) {
+            ::munmap((void*)map, length);
+            throw std::runtime_error(path.string() + ": not a COtt LTS file, or written by an incompatible version");
+        }
+        if (const char* violation = validate()) {
+            ::munmap((void*)map, length);
+            throw std::runtime_error(path.string() + ": corrupted COtt LTS file, " + violation);
+        }
+    }
+    mapped_lts(const mapped_lts&) = delete;
+    mapped_lts& operator=(const mapped_lts&) = delete;
+
+    ~mapped_lts() {
+        ::munmap((void*)map, length);
+    }
+
+    const lts_file_header& header() const {
+        return *(const lts_file_header*)map;
+    }
+
+    std::size_t state_count() const { return header().states; }
+    std::size_t label_count() const { return header().labels; }
+    std::size_t edge_count() const { return header().edges; }
+
+    std::span<const edge> successors(state_id s) const {
+        const auto* rows = (const std::uint64_t*)(map + header().row_offsets);
+        const auto* edges = (const edge*)(map + header().edge_data);
+        return {edges + rows[s], edges + rows[s + 1]};
+    }
+
+    std::shared_ptr<Node> term(state_id s) const {
+        const char* in = value(header().state_offsets, header().state_data, s);
+        return std::make_shared<Node>(serialization_traits<Node>::read(in));
+    }
+
+    Label label(label_id l) const {
+        const char* in = value(header().label_offsets, header().label_data, l);
+        return serialization_traits<Label>::read(in);
+    }
+
+    /**
+     * Deserializing the whole LTS, e.g. for minimizing it
+     */
+    template <typename NodeKeys = structural_keys<Node>>
+    compact_lts<Node, Label, NodeKeys> load() const {
+        compact_lts<Node, Label, NodeKeys> lts;
+        for (state_id s = 0; s<state_count(); s++)
+            lts.add_state(term(s));
+        for (label_id l = 0; l<label_count(); l++)
+            lts.add_label(label(l));
+        for (state_id s = 0; s<state_count(); s++)
+            for (const auto& e : successors(s))
+                lts.add_edge(s, e.label, e.target);
+        lts.freeze();
+        return lts;
+    }
+
+private:
+    /**
+     * @return  Whether count elements of the given size, starting at offset, lie within the file
+     */
+    bool within(std::uint64_t offset, std::uint64_t count, std::size_t size, std::size_t alignment) const {
+        return (offset % alignment == 0) && (offset <= length) && (count <= (length - offset) / size);
+    }
+
+    /**
+     * @return  The first violation of the layout, or null if the file is well-formed
+     */
+    const char* validate() const {
+        const auto& h = header();
+        if ((h.states > std::numeric_limits<state_id>::max()) || (h.labels > std::numeric_limits<label_id>::max()))
+            return "too many states or labels";
+        // Each table is made of count + 1 monotone offsets, the last of which ends within the file
+        auto table = [this](std::uint64_t count, std::uint64_t offsets, std::uint64_t data) {
+            if ((!within(offsets, count + 1, sizeof(std::uint64_t), alignof(std::uint64_t))) || (data > length))
+                return false;
+            const auto* positions = (const std::uint64_t*)(map + offsets);
+            for (std::uint64_t i = 0; i<count; i++)
+                if (positions[i] > positions[i + 1])
+                    return false;
+            return positions[count] <= length - data;
+        };
+        if (!table(h.states, h.state_offsets, h.state_data))
+            return "state table out of bounds";
+        if (!table(h.labels, h.label_offsets, h.label_data))
+            return "label table out of bounds";
+        if ((!within(h.row_offsets, h.states + 1, sizeof(std::uint64_t), alignof(std::uint64_t))) ||
+            (!within(h.edge_data, h.edges, sizeof(edge), alignof(edge))))
+            return "edges out of bounds";
+        const auto* rows = (const std::uint64_t*)(map + h.row_offsets);
+        if (rows[0] != 0)
+            return "rows not starting from the first edge";
+        for (std::uint64_t s = 0; s<h.states; s++)
+            if (rows[s] > rows[s + 1])
+                return "rows not monotone";
+        if (rows[h.states] != h.edges)
+            return "rows not ending at the last edge";
+        const auto* edges = (const edge*)(map + h.edge_data);
+        for (std::uint64_t i = 0; i<h.edges; i++)
+            if ((edges[i].target >= h.states) || (edges[i].label >= h.labels))
+                return "edge towards a missing state or label";
+        return nullptr;
+    }
+
+    const char* value(std::uint64_t offsets, std::uint64_t data, std::size_t i) const {
+        return map + data + ((const std::uint64_t*)(map + offsets))[i];
+    }
+
+    const char* map = nullptr;
+    std::size_t length = 0;
+};
+
+/**
+ * Writing the graph in the Aldebaran format while it is generated, by listening to the exploration. As the numbers of
+ * states and transitions are known only at the end, the header is written with zero-padded placeholders, which are
+ * overwritten by finish. The states are numbered by the exploration, the start being 0, so that the writer retains none.
+ * Each edge is written as notified, and the explorations notify it once: iterative deepening only notifies the graph
+ * of its last round, so that the transitions are neither repeated nor counted twice.
+ */
+template <typename Node, typename Label>
+struct aut_writer {
+    /**
+     * @param path
+     * @param label_name    How to print a label, which is quoted
+     */
+    aut_writer(const std::filesystem::path& path, std::function<std::string(const Label&)> label_name)
+            : file{path, std::ios::trunc}, label_name{std::move(label_name)} {
+        if (!file)
+            throw std::system_error(errno, std::generic_category(), path.string());
+        write_header();
+    }
+
+    ~aut_writer() {
+        finish();
+    }
+
+    /**
+     * @return  Listener to set into small_step_semantics::listener
+     */
+    exploration_listener<Node, Label> listener() {
+        exploration_listener<Node, Label> result;
+        result.on_numbered_state = [this](std::size_t id, const std::shared_ptr<Node>&) { add_state(id); };
+        result.on_numbered_edge = [this](std::size_t src, const Label& label, std::size_t dst) {
+            add_state(src);
+            add_state(dst);
+            file << '(' << src << ",\"";
+            for (char c : label_name(label)) {
+                if ((c == '"') || (c == '\\'))
+                    file << '\\';
+                file << c;
+            }
+            file << "\"," << dst << ")\n";
+            transitions++;
+        };
+        return result;
+    }
+
+    /**
+     * Writing the final numbers of states and transitions in the header, and flushing the file
+     */
+    void finish() {
+        if (!file.is_open())
+            return;
+        file.seekp(0);
+        write_header();
+        file.close();
+    }
+
+private:
+    void write_header() {
+        char header[64];
+        std::snprintf(header, sizeof(header), "des (0,%020llu,%020llu)\n",
+                      (unsigned long long)transitions, (unsigned long long)states);
+        file << header;
+    }
+
+    // The states are numbered densely, thus their count is the greatest number met, plus one
+    void add_state(std::size_t id) {
+        states = std::max(states, id + 1);
+    }
+
+    std::ofstream file;
+    std::function<std::string(const Label&)> label_name;
+    std::size_t states = 0;
+    std::size_t transitions = 0;
+};
+
+/**
+ * Writing the graph in the DOT format while it is generated, by listening to the exploration. The states are numbered
+ * by the exploration, the start being 0, and the initial state is drawn with a double circle. The states and the edges
+ * are written as notified, and the explorations notify each once: iterative deepening only notifies the graph of its
+ * last round.
+ */
+template <typename Node, typename Label>
+struct dot_writer {
+    /**
+     * @param path
+     * @param label_name    How to print a label
+     * @param node_name     How to print a state, if at all
+     */
+    dot_writer(const std::filesystem::path& path, std::function<std::string(const Label&)> label_name,
+               std::function<std::string(const std::shared_ptr<Node>&)> node_name = {})
+            : file{path, std::ios::trunc}, label_name{std::move(label_name)}, node_name{std::move(node_name)} {
+        if (!file)
+            throw std::system_error(errno, std::generic_category(), path.string());
+        file << "digraph lts {\n";
+    }
+
+    ~dot_writer() {
+        finish();
+    }
+
+    exploration_listener<Node, Label> listener() {
+        exploration_listener<Node, Label> result;
+        result.on_numbered_state = [this](std::size_t id, const std::shared_ptr<Node>& t) {
+            file << "  " << id << " [";
+            if (id == 0)
+                file << "shape=doublecircle ";
+            file << "label=\"" << escape(node_name ? node_name(t) : std::to_string(id)) << "\"];\n";
+        };
+        result.on_numbered_edge = [this](std::size_t src, const Label& label, std::size_t dst) {
+            file << "  " << src << " -> " << dst << " [label=\"" << escape(label_name(label)) << "\"];\n";
+        };
+        return result;
+    }
+
+    void finish() {
+        if (!file.is_open())
+            return;
+        file << "}\n";
+        file.close();
+    }
+
+private:
+    static std::string escape(const std::string& s) {
+        std::string escaped;
+        for (char c : s) {
+            if ((c == '"') || (c == '\\'))
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    std::ofstream file;
+    std::function<std::string(const Label&)> label_name;
+    std::function<std::string(const std::shared_ptr<Node>&)> node_name;
+};
+
+#endif //COTT_LTS_FILE_H
@@ -28,46 +28,28 @@
 #define COTT_SMALL_STEP_SEMANTICS_H
 
 #include <operational_semantics/language_semantics.h>
-
-/**
- * Default hasher for a smart-pointer, by exploiting the hash value associated to the pointed object
- * @tparam Key
- */
-template <typename Key>
-struct KeyHasher
-{
-    static_assert(is_std_hashable_v<Key>, "Error: the key should be hashable");
-
-    std::size_t operator()(const std::shared_ptr<Key>& k) const
-    {
-        using std::size_t;
-        using std::hash;
-        using std::string;
-        if (!k) {
-            return 0;
-        } else {
-            return hash<Key>()(*k.get()) * 2 +1;
-        }
-    }
-};
-
-/**
- * Default smart pointer comparator, also encompassing whether the pointer is pointing to null
- * @tparam Key
- */
-template <typename Key>
-struct KeyEqualizer
-{
-    static_assert(CHECK::EqualExists<Key>::value, "Error: the key should come with a default equality predicate");
-
-    bool operator()(const std::shared_ptr<Key>& __x, const std::shared_ptr<Key>& __y) const
-    { return ((((bool) (__x)) == ((bool) (__y)))) && ((!(((bool) (__x)))) || *__x == *__y); }
-
-};
+#include <operational_semantics/key_hasher.h>
+#include <operational_semantics/term_interner.h>
+#include <operational_semantics/term_arena.h>
+#include <operational_semantics/concurrent_exploration.h>
+#include <operational_semantics/compact_lts.h>
+#include <operational_semantics/exploration.h>
+#include <operational_semantics/bisimulation.h>
+#include <operational_semantics/canonical_form.h>
+#include <operational_semantics/disk_state_store.h>
+#include <operational_semantics/tree_compressed_store.h>
+#include <operational_semantics/bitstate.h>
+#include <operational_semantics/checkpoint.h>
+#include <operational_semantics/instrumentation.h>
 
 #include <unordered_map>
 #include <unordered_set>
-#include <stack>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <deque>
+#include <tuple>
+#include <fstream>
 
 template <typename TransitionNode>
 using transition_node_set =  std::unordered_set<std::shared_ptr<TransitionNode>,
@@ -83,49 +65,1143 @@ using transition_node_set =  std::unordered_set<std::shared_ptr<TransitionNode>,
  *
  * @tparam TransitionNode
  * @tparam TransitionLabel
+ * @tparam NodeKeys         How to store the nodes: either by their structure (structural_keys), or by pointer after
+ *                          hash-consing them (interned_keys)
  */
 template <typename TransitionNode,
-        typename TransitionLabel>
+        typename TransitionLabel,
+        typename NodeKeys = structural_keys<TransitionNode>>
 struct small_step_semantics : public language_semantics<TransitionNode,TransitionLabel,TransitionNode> {
     static_assert(is_std_hashable_v<TransitionNode>, "Error: the node type should be hashable, so to fill in a transition graph from the constituents");
     static_assert(CHECK::EqualExists<TransitionNode>::value, "Error: the node type should have an equivalence operator associated to it, otherwise, we cannot determine the node equivalence for generating a transition graph");
     static_assert(is_std_hashable_v<TransitionLabel>, "Error: the transition label type should be hashable, so to guarantee the label unicity");
     static_assert(CHECK::EqualExists<TransitionLabel>::value, "Error: the transition label type should have an equivalence operator associated to it, otherwise, we cannot determine the label equivalence for generating a unique transition label");
 
+    using node_set = std::unordered_set<std::shared_ptr<TransitionNode>,
+            typename NodeKeys::hasher,
+            typename NodeKeys::equalizer>;
 
     std::unordered_map<std::shared_ptr<TransitionNode>,
-            std::unordered_map<TransitionLabel, transition_node_set<TransitionNode>>,
-            KeyHasher<TransitionNode>,
-            KeyEqualizer<TransitionNode>>
+            std::unordered_map<TransitionLabel, node_set>,
+            typename NodeKeys::hasher,
+            typename NodeKeys::equalizer>
 
             forward_transition_graph;
 
-    transition_node_set<TransitionNode> visited_nodes;
+    node_set visited_nodes;
+
+    /**
+     * Visited states that were not expanded yet, as the last exploration stopped early or at its depth bound
+     */
+    node_set frontier;
+
+    /**
+     * Start states of the explorations generating the current graph
+     */
+    std::vector<std::shared_ptr<TransitionNode>> roots;
+
+    /**
+     * Storage policy for the nodes, e.g. holding the interner for the hash-consed nodes
+     */
+    NodeKeys node_keys;
+
+    /**
+     * When set, the region from which the rules allocate the successors via make_term during the visit
+     */
+    std::shared_ptr<term_arena> arena;
+
+    /**
+     * When set, pruning the interleavings of the independent transitions while generating the graph, and while
+     * searching for deadlocks. find_reachable is not reduced, as its predicates might observe any state
+     */
+    partial_order_reduction<TransitionNode, TransitionLabel> reduction;
+
+    /**
+     * When set, rewriting each state into a canonical representative of its equivalent ones before storing it, e.g.
+     * via canonical_form, so that the states differing only by the order of commutative operands are stored once
+     */
+    std::function<std::shared_ptr<TransitionNode>(const std::shared_ptr<TransitionNode>&)> canonicalize;
 
+    /**
+     * Notified of the states and of the edges added by visit, add_root and visit_external, e.g. by aut_writer. As
+     * each round of iterative deepening restarts from an empty graph, only the graph of its last round is notified,
+     * once all the rounds are over
+     */
+    exploration_listener<TransitionNode, TransitionLabel> listener;
 
-    void visit(const std::shared_ptr<TransitionNode>& start) {
-        // Clearing from previous computations
+    /**
+     * When set, recording the graph generated by visit and add_root into an append-only log, committed periodically
+     * by the depth-first and breadth-first searches and at the end of each exploration, so that resume carries on an
+     * interrupted one. The node and label types shall be serializable
+     */
+    std::shared_ptr<exploration_checkpoint<TransitionNode, TransitionLabel>> checkpoint;
+
+    /**
+     * Progress callbacks and summary of visit, add_root, resume, visit_external and visit_bitstate, which are only
+     * collected when the instrumentation is enabled
+     */
+    exploration_telemetry telemetry;
+
+    small_step_semantics() = default;
+    // A copy would share the arena holding the terms of its graph, which either one releases when cleared
+    small_step_semantics(const small_step_semantics&) = delete;
+    small_step_semantics& operator=(const small_step_semantics&) = delete;
+    small_step_semantics(small_step_semantics&&) = default;
+    small_step_semantics& operator=(small_step_semantics&&) = default;
+
+    // The terms allocated in the arena are released before the arena itself
+    ~small_step_semantics() {
+        clear();
+    }
+
+    /**
+     * Forgetting the generated graph, alongside the interned and memoized terms and the checkpointed graph, and
+     * freeing the arena in bulk. After this, no term allocated in the arena shall be still in use.
+     */
+    void clear() {
         visited_nodes.clear();
         forward_transition_graph.clear();
-        // Starting the recursive view over the language
-        std::stack<std::shared_ptr<TransitionNode>> S;
-        S.emplace(start);
+        frontier.clear();
+        roots.clear();
+        node_keys.clear();
+        state_numbers.clear();
+        if (checkpoint)
+            checkpoint->discard();
+        this->invalidate();
+        if (arena)
+            arena->release();
+    }
+
+    /**
+     * Generating the graph of the states reachable from start, by expanding each of them through the rules. Each
+     * state is scheduled only once, when it is first discovered, unless it is later reached through a shorter path
+     * in a depth-bounded search.
+     *
+     * @param start
+     * @param options   Strategy, and budgets after which the exploration stops with the graph generated so far
+     * @return          Why the exploration stopped, and its statistics
+     */
+    exploration_result visit(const std::shared_ptr<TransitionNode>& start, const exploration_options& options = {}) {
+        std::optional<term_arena::scope> region;
+        if (arena)
+            region.emplace(*arena);
+        exploration_run run{options, std::chrono::steady_clock::now(), {}, {}};
+        auto root = canonical_node(start);
+        roots.assign(1, root);
+        switch (options.strategy) {
+            case exploration_strategy::depth_first:
+                restart(root, run);
+                depth_first_search({{root, 0}}, run);
+                break;
+            case exploration_strategy::breadth_first:
+                restart(root, run);
+                breadth_first_search({root}, run);
+                break;
+            case exploration_strategy::depth_bounded:
+                bounded_search(root, options.max_depth ? options.max_depth : std::numeric_limits<std::size_t>::max(), run);
+                break;
+            case exploration_strategy::iterative_deepening: {
+                auto listening = std::exchange(listener, {});
+                try {
+                    for (std::size_t bound = 0; ; bound++) {
+                        bounded_search(root, bound, run);
+                        if ((run.result.status != exploration_status::depth_bound_reached) ||
+                            ((options.max_depth > 0) && (bound >= options.max_depth)))
+                            break;
+                    }
+                } catch (...) {
+                    listener = std::move(listening);
+                    throw;
+                }
+                listener = std::move(listening);
+                notify_graph(root);
+                break;
+            }
+        }
+        if (checkpoint)
+            checkpoint->commit(roots, frontier);
+        run.result.states = visited_nodes.size();
+        run.result.memory = estimated_memory(run.result.edges);
+        run.result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run.begin).count();
+        summarize(run, frontier.size());
+        return run.result;
+    }
+
+    /**
+     * Extending the current graph with the states reachable from start, thus expanding only the states that were
+     * not expanded yet: the new ones, and the frontier left by the previous explorations. The depth bounds are
+     * ignored, as the distance from the new start of the already visited states is unknown, and the states are
+     * visited breadth-first for the breadth-first strategy, depth-first otherwise. The returned edges are the ones
+     * added by this call.
+     *
+     * @param start
+     * @param options
+     */
+    exploration_result add_root(const std::shared_ptr<TransitionNode>& start, const exploration_options& options = {}) {
+        std::optional<term_arena::scope> region;
+        if (arena)
+            region.emplace(*arena);
+        exploration_run run{options, std::chrono::steady_clock::now(), {}, {}};
+        auto root = canonical_node(start);
+        if (std::find_if(roots.begin(), roots.end(), [&root](const auto& r) { return typename NodeKeys::equalizer()(r, root); }) == roots.end())
+            roots.emplace_back(root);
+        std::vector<node_ptr> seeds(frontier.begin(), frontier.end());
+        frontier.clear();
+        if (visited_nodes.emplace(root).second) {
+            notify(root);
+            if (checkpoint)
+                checkpoint->add_state(root);
+            seeds.emplace_back(root);
+        }
+        expand_frontier(std::move(seeds), run);
+        return run.result;
+    }
+
+    /**
+     * Restoring the graph from the last commit of the checkpoint log, and carrying on its generation as add_root
+     * would, so that the final graph is the one of the interrupted exploration. The restored states are not notified
+     * to the listener, and the checkpoint is kept for the following explorations.
+     *
+     * @param from      Checkpoint log of the interrupted exploration
+     * @param options   As for add_root, while the statistics count only the work done by this call
+     */
+    exploration_result resume(std::shared_ptr<exploration_checkpoint<TransitionNode, TransitionLabel>> from,
+                              const exploration_options& options = {}) {
+        clear();
+        checkpoint = std::move(from);
+        std::optional<term_arena::scope> region;
+        if (arena)
+            region.emplace(*arena);
+        exploration_run run{options, std::chrono::steady_clock::now(), {}, {}};
+        auto restored = checkpoint->restore([this](const node_ptr& t) { return node_keys.canonical(t); },
+                                            [this](const node_ptr& t) { visited_nodes.emplace(t); },
+                                            [this](const node_ptr& src, const TransitionLabel& label, const node_ptr& dst) {
+                                                forward_transition_graph[src][label].emplace(dst);
+                                            });
+        roots = std::move(restored.roots);
+        expand_frontier(std::move(restored.pending), run);
+        return run.result;
+    }
+
+    /**
+     * Writing the telemetry of the last exploration as JSON: its outcome and progress, the allocations it performed,
+     * the collisions in the hash table of the visited states, and the statistics of the rules
+     */
+    void write_telemetry(std::ostream& os) const {
+        std::size_t occupied = 0;
+        for (std::size_t b = 0, N = visited_nodes.bucket_count(); b<N; b++)
+            occupied += visited_nodes.bucket_size(b) > 0;
+        os << "{\"status\":\"" << to_string(telemetry.result.status) << "\",\"progress\":";
+        telemetry.progress.write_json(os);
+        os << ",\"pruned\":" << telemetry.result.pruned << ",\"memory\":" << telemetry.result.memory
+           << ",\"max_frontier\":" << telemetry.max_frontier << ",\"allocations\":{\"count\":"
+           << telemetry.allocations.count << ",\"bytes\":" << telemetry.allocations.bytes
+           << "},\"visited_set\":{\"size\":" << visited_nodes.size() << ",\"buckets\":" << visited_nodes.bucket_count()
+           << ",\"load_factor\":" << visited_nodes.load_factor() << ",\"collisions\":" << (visited_nodes.size() - occupied)
+           << "},\"rules\":";
+        this->profile.write_json(os);
+        os << "}\n";
+    }
+
+    /**
+     * @return  The states of the current graph reachable from start, which is included if visited
+     */
+    node_set reachable_from(const std::shared_ptr<TransitionNode>& start) {
+        node_set reached;
+        auto root = canonical_node(start);
+        if (!visited_nodes.contains(root))
+            return reached;
+        std::vector<node_ptr> S{root};
+        reached.emplace(root);
         while (!S.empty()) {
-            auto top = S.top();
-            S.pop();
-            if (visited_nodes.contains(top)) continue; // Visiting the expression only if we haven't done it yet
-            visited_nodes.emplace(top); // Adding this to the visited nodesz
-            // Using the parent's associated expression for evaluating the next steps to be computed
-            // This is why the returned type has to be the same of the input type, otherwise we cannot
-            // engage with a recursive call.
-            std::vector<std::pair<TransitionLabel,std::shared_ptr<TransitionNode>>> result = this->operator()(top);
-            for (const auto& [label, dst] : result) {
-                auto& adjList = forward_transition_graph[top];
-                auto& dstPlace = adjList[label];
-                dstPlace.emplace(dst); // Adding this to the graph
-                S.emplace(dst); // Adding this to the recursive view, only if we haven't visited it yet!
+            auto top = std::move(S.back());
+            S.pop_back();
+            auto it = forward_transition_graph.find(top);
+            if (it == forward_transition_graph.end())
+                continue;
+            for (const auto& [label, dst] : it->second)
+                for (const auto& t : dst)
+                    if (reached.emplace(t).second)
+                        S.emplace_back(t);
+        }
+        return reached;
+    }
+
+    /**
+     * Searching breadth-first for a state reachable from start and satisfying accepting, which is tested as soon as
+     * each state is discovered. The search stops at the first match, returning the shortest trace leading to it,
+     * without generating forward_transition_graph. The strategy in the options is ignored, while the budgets apply.
+     *
+     * @param start
+     * @param accepting     Predicate over the states
+     * @param options
+     */
+    template <typename Predicate>
+    query_result<TransitionNode, TransitionLabel> find_reachable(const std::shared_ptr<TransitionNode>& start,
+                                                                 Predicate&& accepting,
+                                                                 const exploration_options& options = {}) {
+        return query(start, [&accepting](const node_ptr& t, std::size_t) { return (bool)accepting(t); }, options);
+    }
+
+    /**
+     * Searching for the closest state reachable from start and having no outgoing transitions, as find_reachable
+     */
+    query_result<TransitionNode, TransitionLabel> find_deadlock(const std::shared_ptr<TransitionNode>& start,
+                                                                const exploration_options& options = {}) {
+        return query(start, [](const node_ptr&, std::size_t successors) { return successors == 0; }, options, true);
+    }
+
+    /**
+     * Generating the same graph as visit into a compact_lts, where the states are numbered in order of discovery and
+     * the edges are frozen in a compressed sparse row layout, without filling forward_transition_graph nor
+     * visited_nodes. If an arena is set, the returned terms are allocated there.
+     */
+    compact_lts<TransitionNode, TransitionLabel, NodeKeys> visit_compact(const std::shared_ptr<TransitionNode>& start) {
+        using lts_type = compact_lts<TransitionNode, TransitionLabel, NodeKeys>;
+        lts_type lts;
+        std::optional<term_arena::scope> region;
+        if (arena)
+            region.emplace(*arena);
+        // Each state is pushed once, when discovered
+        std::vector<typename lts_type::state_id> S;
+        std::vector<std::pair<TransitionLabel, node_ptr>> successors;
+        S.push_back(lts.add_state(canonical_node(start)).first);
+        while (!S.empty()) {
+            auto src = S.back();
+            S.pop_back();
+            auto top = lts.term(src);
+            if (!reduction) {
+                this->emit(top, [this, &lts, &S, src](const TransitionLabel& label, const std::shared_ptr<TransitionNode>& successor) {
+                    auto [dst, discovered] = lts.add_state(canonical_node(successor));
+                    lts.add_edge(src, lts.add_label(label), dst);
+                    if (discovered)
+                        S.push_back(dst);
+                });
+                continue;
+            }
+            successors.clear();
+            this->emit(top, [this, &successors](const TransitionLabel& label, const node_ptr& successor) {
+                successors.emplace_back(label, canonical_node(successor));
+            });
+            reduce(top, successors, [&lts](const node_ptr& t) { return lts.find(t).has_value(); });
+            for (const auto& [label, successor] : successors) {
+                auto [dst, discovered] = lts.add_state(successor);
+                lts.add_edge(src, lts.add_label(label), dst);
+                if (discovered)
+                    S.push_back(dst);
+            }
+        }
+        lts.freeze();
+        return lts;
+    }
+
+    /**
+     * Freezing the current graph into a compact_lts, e.g. for minimizing it. The roots come first, in order, followed
+     * by the other visited states in order of discovery through the graph
+     */
+    compact_lts<TransitionNode, TransitionLabel, NodeKeys> compact() const {
+        using lts_type = compact_lts<TransitionNode, TransitionLabel, NodeKeys>;
+        lts_type lts;
+        std::vector<typename lts_type::state_id> S;
+        auto discover = [&lts, &S](const node_ptr& t) {
+            auto [id, discovered] = lts.add_state(t);
+            if (discovered)
+                S.push_back(id);
+            return id;
+        };
+        for (const auto& root : roots)
+            discover(root);
+        for (auto it = visited_nodes.begin(); ; ) {
+            while (!S.empty()) {
+                auto src = S.back();
+                S.pop_back();
+                auto adj = forward_transition_graph.find(lts.term(src));
+                if (adj == forward_transition_graph.end())
+                    continue;
+                for (const auto& [label, dst] : adj->second)
+                    for (const auto& t : dst)
+                        lts.add_edge(src, lts.add_label(label), discover(t));
+            }
+            // Visited states not reachable from the roots, if any
+            for (; (it != visited_nodes.end()) && lts.find(*it); it++);
+            if (it == visited_nodes.end())
+                break;
+            discover(*it);
+        }
+        lts.freeze();
+        return lts;
+    }
+
+    /**
+     * Generating the graph of the states reachable from start into a store of serialized states, so that neither
+     * forward_transition_graph nor visited_nodes is filled: a disk_state_store keeps neither the states nor the edges
+     * in RAM, while a tree_compressed_store keeps the states in RAM as tables of shared subterms. The states are
+     * expanded breadth-first, in the order they are stored, by reading them back from the store one at a time.
+     * If the store is not empty, start is added to it, and the exploration resumes from the first state not expanded
+     * yet. As the interned terms and the arena would retain all the states, only canonicalize is applied to them.
+     *
+     * @param start
+     * @param store
+     * @param options   The strategy is ignored, while the depth bound is counted from the first state expanded by
+     *                  this call, and the memory budget bounds the RAM held by the store
+     */
+    template <typename Store>
+    exploration_result visit_external(const std::shared_ptr<TransitionNode>& start, Store& store,
+                                      const exploration_options& options = {}) {
+        exploration_run run{options, std::chrono::steady_clock::now(), {}, {}};
+        auto canonical = [this](const node_ptr& t) { return canonicalize ? canonicalize(t) : t; };
+        auto root = canonical(start);
+        if (auto [id, discovered] = store.add_state(root); discovered)
+            notify(id, root);
+        std::size_t layer_end = store.state_count();
+        auto& successors = run.successors;
+        while (store.expanded < store.state_count()) {
+            if (store.expanded == layer_end) {
+                run.result.depth++;
+                layer_end = store.state_count();
             }
+            if ((options.max_depth > 0) && (run.result.depth >= options.max_depth)) {
+                run.result.status = exploration_status::depth_bound_reached;
+                break;
+            }
+            if (!within_budget(run, store.memory()))
+                break;
+            auto src = (typename Store::state_id)store.expanded;
+            auto top = store.state(src);
+            successors.clear();
+            this->emit(top, [&successors, &canonical](const TransitionLabel& label, const node_ptr& successor) {
+                successors.emplace_back(label, canonical(successor));
+            });
+            run.result.pruned += reduce(top, successors, [&store](const node_ptr& t) { return store.find(t).has_value(); });
+            if ((options.max_states > 0) && (store.state_count() + successors.size() > options.max_states)) {
+                std::size_t fresh = 0;
+                for (const auto& [label, dst] : successors)
+                    fresh += !store.find(dst);
+                if (store.state_count() + fresh > options.max_states) {
+                    stop(run, exploration_status::state_budget_exceeded);
+                    break;
+                }
+            }
+            if ((options.max_edges > 0) && (run.result.edges + successors.size() > options.max_edges)) {
+                stop(run, exploration_status::edge_budget_exceeded);
+                break;
+            }
+            for (const auto& [label, successor] : successors) {
+                auto [dst, discovered] = store.add_state(successor);
+                if (discovered)
+                    notify(dst, successor);
+                store.add_edge(src, store.add_label(label), dst);
+                notify_edge(src, top, label, dst, successor);
+                if constexpr (instrumentation_enabled)
+                    run.duplicates += !discovered;
+                run.result.edges++;
+            }
+            run.result.expansions++;
+            store.expanded++;
+            report_progress(run, store.state_count() - store.expanded, store.state_count());
         }
+        run.result.states = store.state_count();
+        run.result.memory = store.memory();
+        run.result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run.begin).count();
+        summarize(run, store.state_count() - store.expanded);
+        return run.result;
+    }
+
+    /**
+     * Approximately exploring the states reachable from start, for finding errors in state spaces too large to be
+     * stored: the visited states are only recorded as their hashes in filter, so that the memory is bounded by the
+     * filter and by the pending states, while some states might be omitted. Neither the graph nor the visited states
+     * are kept, and the edges are only notified to the listener. As the interned terms and the arena would retain all
+     * the states, only canonicalize is applied to them. When the edges are listened to, the hashes of the notified
+     * states are kept alongside their numbers, so that an edge is notified only if it leads to a notified state: the
+     * edges leading to an omitted state, whose bits were all set by other states, are omitted alongside it.
+     *
+     * @param start
+     * @param filter    Bits set by the visited states, which can be reused across calls so to skip the states already
+     *                  visited, e.g. with a differently seeded hash in the rules
+     * @param options   The breadth-first strategy keeps the pending states in a queue, and any other one in a stack,
+     *                  while the depth bound, if set, is enforced by either. The memory budget includes the filter
+     */
+    bitstate_result visit_bitstate(const std::shared_ptr<TransitionNode>& start, bitstate_filter& filter,
+                                   const exploration_options& options = {}) {
+        exploration_run run{options, std::chrono::steady_clock::now(), {}, {}};
+        KeyHasher<TransitionNode> hasher;
+        auto canonical = [this](const node_ptr& t) { return canonicalize ? canonicalize(t) : t; };
+        bool breadth_first = options.strategy == exploration_strategy::breadth_first;
+        // Pending states, alongside their depth and number
+        std::deque<std::tuple<node_ptr, std::size_t, std::size_t>> pending;
+        std::unordered_map<std::size_t, std::size_t> notified;
+        bool edges_listened = listener.on_edge || listener.on_numbered_edge;
+        std::size_t states = 0;
+        auto root = canonical(start);
+        if (std::size_t h = hasher(root); filter.insert(h)) {
+            notify(states, root);
+            if (edges_listened)
+                notified.emplace(h, states);
+            pending.emplace_back(root, 0, states++);
+        }
+        auto memory = [&filter, &pending, &notified]() {
+            return filter.memory() + pending.size() * (sizeof(typename decltype(pending)::value_type) + sizeof(TransitionNode)) +
+                   notified.size() * 3 * sizeof(std::size_t);
+        };
+        auto& successors = run.successors;
+        while (!pending.empty()) {
+            if (!within_budget(run, memory()))
+                break;
+            auto [top, depth, src] = breadth_first ? pending.front() : pending.back();
+            if (breadth_first)
+                pending.pop_front();
+            else
+                pending.pop_back();
+            run.result.depth = std::max(run.result.depth, depth);
+            if ((options.max_depth > 0) && (depth >= options.max_depth)) {
+                run.result.status = exploration_status::depth_bound_reached;
+                continue;
+            }
+            successors.clear();
+            this->emit(top, [&successors, &canonical](const TransitionLabel& label, const node_ptr& successor) {
+                successors.emplace_back(label, canonical(successor));
+            });
+            run.result.pruned += reduce(top, successors, [&filter, &hasher](const node_ptr& t) { return filter.contains(hasher(t)); });
+            if ((options.max_edges > 0) && (run.result.edges + successors.size() > options.max_edges)) {
+                stop(run, exploration_status::edge_budget_exceeded);
+                break;
+            }
+            for (const auto& [label, successor] : successors) {
+                std::size_t h = hasher(successor);
+                if (filter.insert(h)) {
+                    if ((options.max_states > 0) && (states >= options.max_states)) {
+                        stop(run, exploration_status::state_budget_exceeded);
+                        break;
+                    }
+                    notify(states, successor);
+                    if (edges_listened)
+                        notified.emplace(h, states);
+                    pending.emplace_back(successor, depth + 1, states++);
+                } else if constexpr (instrumentation_enabled) {
+                    run.duplicates++;
+                }
+                if (edges_listened)
+                    if (auto dst = notified.find(h); dst != notified.end())
+                        notify_edge(src, top, label, dst->second, successor);
+                run.result.edges++;
+            }
+            if (!run.result.completed() && (run.result.status != exploration_status::depth_bound_reached))
+                break;
+            run.result.expansions++;
+            report_progress(run, pending.size(), states);
+        }
+        run.result.states = states;
+        run.result.memory = memory();
+        run.result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run.begin).count();
+        summarize(run, pending.size());
+        bitstate_result answer;
+        answer.exploration = run.result;
+        answer.coverage = filter.estimated_coverage();
+        answer.omission_probability = filter.omission_probability();
+        return answer;
+    }
+
+    /**
+     * Generating the same graph as visit, by expanding the nodes from multiple threads. Each thread pops its pending
+     * nodes from its own deque, and steals from the other threads' ones when this is empty. A node is scheduled only
+     * by the thread first inserting it in a sharded visited set, while the edges are stored per thread and merged at
+     * the end.
+     *
+     * The rules shall be safe to call concurrently. As the memoization cache, the evaluation limits and the arena are
+     * not shared across threads, this falls back to visit whenever either of these, or the reduction, is set. The
+     * interned node keys are canonicalized under a lock. It also falls back to visit when the instrumentation is
+     * enabled, as the rule statistics are not updated atomically, and when the checkpoint is set, as only visit
+     * records the graph into its log.
+     *
+     * @param start
+     * @param threads   Number of worker threads
+     */
+    void parallel_visit(const std::shared_ptr<TransitionNode>& start,
+                        std::size_t threads = std::thread::hardware_concurrency()) {
+        if ((threads <= 1) || instrumentation_enabled || this->memoization() || arena || reduction || checkpoint ||
+            (this->limits.native_depth > 0) || (this->limits.max_depth > 0)) {
+            visit(start);
+            return;
+        }
+        using node = std::shared_ptr<TransitionNode>;
+        using adjacency = std::unordered_map<TransitionLabel, node_set>;
+        visited_nodes.clear();
+        forward_transition_graph.clear();
+        frontier.clear();
+
+        sharded_node_set<TransitionNode, typename NodeKeys::hasher, typename NodeKeys::equalizer> discovered(threads * 16);
+        std::unique_ptr<work_stealing_deque<node>[]> pending{new work_stealing_deque<node>[threads]};
+        std::vector<decltype(forward_transition_graph)> edges(threads);
+        std::atomic<std::size_t> scheduled{1};
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;
+        std::mutex keys_mutex, error_mutex;
+        auto canonical = [this, &keys_mutex](const node& t) -> node {
+            auto u = canonicalize ? canonicalize(t) : t;
+            if constexpr (std::is_same_v<NodeKeys, structural_keys<TransitionNode>>) {
+                return u;
+            } else {
+                std::lock_guard<std::mutex> lock{keys_mutex};
+                return node_keys.canonical(u);
+            }
+        };
+
+        auto root = canonical(start);
+        roots.assign(1, root);
+        discovered.insert(root);
+        pending[0].push(root);
+        auto worker = [&](std::size_t id) {
+            auto& own = pending[id];
+            auto& graph = edges[id];
+            while ((scheduled.load() > 0) && !failed.load()) {
+                auto top = own.pop();
+                for (std::size_t i = 1; (!top) && (i < threads); i++)
+                    top = pending[(id + i) % threads].steal();
+                if (!top) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                try {
+                    adjacency adjList;
+                    this->emit(*top, [&](const TransitionLabel& label, const node& successor) {
+                        auto dst = canonical(successor);
+                        adjList[label].emplace(dst);
+                        if (discovered.insert(dst)) {
+                            scheduled.fetch_add(1);
+                            own.push(std::move(dst));
+                        }
+                    });
+                    if (!adjList.empty())
+                        graph.emplace(std::move(*top), std::move(adjList));
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock{error_mutex};
+                    if (!error)
+                        error = std::current_exception();
+                    failed.store(true);
+                }
+                scheduled.fetch_sub(1);
+            }
+        };
+        std::vector<std::thread> workers;
+        for (std::size_t i = 1; i<threads; i++)
+            workers.emplace_back(worker, i);
+        worker(0);
+        for (auto& w : workers)
+            w.join();
+        if (error)
+            std::rethrow_exception(error);
+
+        // Merging the per-thread stores: each node was expanded by exactly one thread
+        discovered.drain([this](const node& t) { visited_nodes.emplace(t); });
+        for (auto& graph : edges) {
+            for (auto& [src, adjList] : graph)
+                forward_transition_graph.emplace(src, std::move(adjList));
+            graph.clear();
+        }
+    }
+
+private:
+    using node_ptr = std::shared_ptr<TransitionNode>;
+
+    /**
+     * Canonical representative of a state, as stored in the visited set and in the graph
+     */
+    node_ptr canonical_node(const node_ptr& t) {
+        return node_keys.canonical(canonicalize ? canonicalize(t) : t);
+    }
+
+    /**
+     * Numbers of the states of the graph notified to on_numbered_state and on_numbered_edge, which are only filled
+     * when either is set. They are kept across the explorations until clear, as the listener might outlive them
+     */
+    std::unordered_map<node_ptr, std::size_t, typename NodeKeys::hasher, typename NodeKeys::equalizer> state_numbers;
+
+    /**
+     * Number of a state of the graph, in order of first discovery since the last clear
+     */
+    std::size_t state_number(const node_ptr& t) {
+        return state_numbers.try_emplace(t, state_numbers.size()).first->second;
+    }
+
+    void notify(const node_ptr& t) {
+        if (listener.on_state)
+            listener.on_state(t);
+        if (listener.on_numbered_state)
+            listener.on_numbered_state(state_number(t), t);
+    }
+
+    void notify_edge(const node_ptr& src, const TransitionLabel& label, const node_ptr& dst) {
+        if (listener.on_edge)
+            listener.on_edge(src, label, dst);
+        if (listener.on_numbered_edge)
+            listener.on_numbered_edge(state_number(src), label, state_number(dst));
+    }
+
+    /**
+     * Notifying the states and edges of the explorations not storing the graph, which number the states by themselves
+     */
+    void notify(std::size_t id, const node_ptr& t) {
+        if (listener.on_state)
+            listener.on_state(t);
+        if (listener.on_numbered_state)
+            listener.on_numbered_state(id, t);
+    }
+
+    void notify_edge(std::size_t src_id, const node_ptr& src, const TransitionLabel& label, std::size_t dst_id, const node_ptr& dst) {
+        if (listener.on_edge)
+            listener.on_edge(src, label, dst);
+        if (listener.on_numbered_edge)
+            listener.on_numbered_edge(src_id, label, dst_id);
+    }
+
+    /**
+     * Notifying the states and the edges of the graph, visited breadth-first from root
+     */
+    void notify_graph(const node_ptr& root) {
+        if (!(listener.on_state || listener.on_edge || listener.on_numbered_state || listener.on_numbered_edge))
+            return;
+        node_set notified{root};
+        std::deque<node_ptr> pending{root};
+        notify(root);
+        while (!pending.empty()) {
+            auto src = std::move(pending.front());
+            pending.pop_front();
+            auto adjList = forward_transition_graph.find(src);
+            if (adjList == forward_transition_graph.end())
+                continue;
+            for (const auto& [label, targets] : adjList->second) {
+                for (const auto& dst : targets) {
+                    if (notified.emplace(dst).second) {
+                        notify(dst);
+                        pending.emplace_back(dst);
+                    }
+                    notify_edge(src, label, dst);
+                }
+            }
+        }
+    }
+
+    struct exploration_run {
+        const exploration_options& options;
+        std::chrono::steady_clock::time_point begin;
+        exploration_result result;
+        std::vector<std::pair<TransitionLabel, node_ptr>> successors;   ///< Reused across the expansions
+
+        // Only updated when the instrumentation is enabled
+        std::size_t duplicates = 0;
+        std::size_t max_frontier = 0;
+        std::chrono::steady_clock::time_point reported = begin;
+        allocation_counters allocations = allocation_counters::local();
+    };
+
+    exploration_progress progress(const exploration_run& run, std::size_t pending, std::size_t states) const {
+        exploration_progress p;
+        p.states = states;
+        p.edges = run.result.edges;
+        p.expansions = run.result.expansions;
+        p.frontier = pending;
+        p.duplicates = run.duplicates;
+        p.depth = run.result.depth;
+        p.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run.begin).count();
+        return p;
+    }
+
+    /**
+     * Calling the progress callback, if due, after an expansion leaving the given number of states to be expanded
+     */
+    void report_progress(exploration_run& run, std::size_t pending, std::size_t states) {
+        if constexpr (instrumentation_enabled) {
+            run.max_frontier = std::max(run.max_frontier, pending);
+            // Reading the clock every few expansions only
+            if (!telemetry.on_progress || (run.result.expansions % 64 != 0))
+                return;
+            auto now = std::chrono::steady_clock::now();
+            if (now - run.reported < telemetry.every)
+                return;
+            run.reported = now;
+            telemetry.on_progress(progress(run, pending, states));
+        }
+    }
+
+    /**
+     * Storing the telemetry of the run that just ended, and writing its summary if requested
+     */
+    void summarize(const exploration_run& run, std::size_t pending) {
+        if constexpr (instrumentation_enabled) {
+            telemetry.result = run.result;
+            telemetry.progress = progress(run, pending, run.result.states);
+            telemetry.progress.elapsed_ms = run.result.elapsed_ms;
+            telemetry.max_frontier = run.max_frontier;
+            const auto& now = allocation_counters::local();
+            telemetry.allocations = {now.count - run.allocations.count, now.bytes - run.allocations.bytes};
+            if (telemetry.summary.empty())
+                return;
+            std::ofstream file{telemetry.summary, std::ios::trunc};
+            write_telemetry(file);
+        }
+    }
+
+    /**
+     * Estimating the bytes used by the visited states, by their terms, and by the graph
+     */
+    std::size_t estimated_memory(std::size_t edges) const {
+        // Each hash table entry is a node holding the value, the next pointer and the cached hash, plus a bucket
+        constexpr std::size_t entry_overhead = 3 * sizeof(void*);
+        std::size_t states = visited_nodes.size();
+        std::size_t terms = arena ? arena->allocated_bytes : states * sizeof(TransitionNode);
+        return terms + states * (sizeof(node_ptr) + entry_overhead) +
+               forward_transition_graph.size() * (sizeof(typename decltype(forward_transition_graph)::value_type) + entry_overhead) +
+               edges * (sizeof(node_ptr) + sizeof(TransitionLabel) + 2 * entry_overhead);
+    }
+
+    /**
+     * Checking the time and memory budgets
+     */
+    static bool within_budget(exploration_run& run, std::size_t memory) {
+        const auto& options = run.options;
+        if ((options.max_time.count() > 0) && (std::chrono::steady_clock::now() - run.begin > options.max_time))
+            return stop(run, exploration_status::time_budget_exceeded);
+        if ((options.max_memory > 0) && (memory > options.max_memory))
+            return stop(run, exploration_status::memory_budget_exceeded);
+        return true;
+    }
+
+    static bool stop(exploration_run& run, exploration_status status) {
+        run.result.status = status;
+        return false;
+    }
+
+    /**
+     * Expanding top, so to add all of its edges to the graph and to notify each successor to discover, alongside
+     * whether it was not visited before. If expanding top would exceed a budget, this leaves top unexpanded
+     * @return  Whether top was expanded
+     */
+    template <typename Discover>
+    bool expand(const node_ptr& top, exploration_run& run, Discover&& discover) {
+        const auto& options = run.options;
+        if (!within_budget(run, estimated_memory(run.result.edges)))
+            return false;
+        auto& successors = run.successors;
+        successors.clear();
+        this->emit(top, [this, &successors](const TransitionLabel& label, const node_ptr& successor) {
+            successors.emplace_back(label, canonical_node(successor));
+        });
+        run.result.pruned += reduce(top, successors, [this](const node_ptr& t) { return visited_nodes.contains(t); });
+        if (options.max_states > 0) {
+            std::size_t fresh = 0;
+            for (const auto& [label, dst] : successors)
+                fresh += !visited_nodes.contains(dst);
+            if (visited_nodes.size() + fresh > options.max_states)
+                return stop(run, exploration_status::state_budget_exceeded);
+        }
+        if ((options.max_edges > 0) && (run.result.edges + successors.size() > options.max_edges))
+            return stop(run, exploration_status::edge_budget_exceeded);
+        run.result.expansions++;
+        if (successors.empty())
+            return true;
+        auto& adjList = forward_transition_graph[top];
+        for (const auto& [label, dst] : successors) {
+            auto [stored, discovered] = visited_nodes.emplace(dst);
+            if (discovered)
+                notify(dst);
+            else if constexpr (instrumentation_enabled)
+                run.duplicates++;
+            if (adjList[label].emplace(dst).second) {
+                run.result.edges++;
+                notify_edge(top, label, *stored);
+                if (checkpoint)
+                    checkpoint->add_edge(top, label, *stored);
+            }
+            discover(*stored, discovered);
+        }
+        return true;
+    }
+
+    /**
+     * Breadth-first search remembering, for each discovered state, the state and the label through which it was first
+     * discovered. Each state is tested when discovered, as well as when expanded if after_expansion, alongside its
+     * number of successors, which is zero until expanded. Only the latter searches are reduced, as they just observe
+     * whether a state has successors
+     */
+    template <typename Test>
+    query_result<TransitionNode, TransitionLabel> query(const std::shared_ptr<TransitionNode>& start, Test&& test,
+                                                        const exploration_options& options, bool after_expansion = false) {
+        std::optional<term_arena::scope> region;
+        if (arena)
+            region.emplace(*arena);
+        exploration_run run{options, std::chrono::steady_clock::now(), {}, {}};
+        query_result<TransitionNode, TransitionLabel> answer;
+        std::unordered_map<node_ptr, std::pair<node_ptr, std::optional<TransitionLabel>>,
+                typename NodeKeys::hasher, typename NodeKeys::equalizer> parent;
+        constexpr std::size_t entry_size = sizeof(typename decltype(parent)::value_type) + 3 * sizeof(void*);
+        auto memory = [this, &parent]() {
+            return (arena ? arena->allocated_bytes : parent.size() * sizeof(TransitionNode)) + parent.size() * entry_size;
+        };
+        auto found = [&parent, &answer](node_ptr t) {
+            witness_trace<TransitionNode, TransitionLabel> trace;
+            for (auto it = parent.find(t); it->second.second; it = parent.find(t)) {
+                trace.states.emplace_back(t);
+                trace.labels.emplace_back(*it->second.second);
+                t = it->second.first;
+            }
+            trace.states.emplace_back(t);
+            std::reverse(trace.states.begin(), trace.states.end());
+            std::reverse(trace.labels.begin(), trace.labels.end());
+            answer.witness = std::move(trace);
+        };
+
+        auto root = canonical_node(start);
+        parent.emplace(root, std::make_pair(node_ptr{}, std::optional<TransitionLabel>{}));
+        std::vector<node_ptr> layer, next;
+        if (!after_expansion && test(root, 0))
+            found(root);
+        else
+            layer.emplace_back(root);
+        std::vector<std::pair<TransitionLabel, node_ptr>> successors;
+        for (std::size_t depth = 0; !layer.empty() && !answer.witness; depth++) {
+            run.result.depth = depth;
+            if ((options.max_depth > 0) && (depth >= options.max_depth)) {
+                run.result.status = exploration_status::depth_bound_reached;
+                break;
+            }
+            for (const auto& top : layer) {
+                if (!within_budget(run, memory()))
+                    break;
+                successors.clear();
+                this->emit(top, [this, &successors](const TransitionLabel& label, const node_ptr& successor) {
+                    successors.emplace_back(label, canonical_node(successor));
+                });
+                if (after_expansion)
+                    run.result.pruned += reduce(top, successors, [&parent](const node_ptr& t) { return parent.contains(t); });
+                run.result.expansions++;
+                run.result.edges += successors.size();
+                if (after_expansion && test(top, successors.size())) {
+                    found(top);
+                    break;
+                }
+                for (const auto& [label, dst] : successors) {
+                    if (parent.contains(dst))
+                        continue;
+                    if ((options.max_states > 0) && (parent.size() >= options.max_states)) {
+                        stop(run, exploration_status::state_budget_exceeded);
+                        break;
+                    }
+                    parent.emplace(dst, std::make_pair(top, std::optional<TransitionLabel>{label}));
+                    if (!after_expansion && test(dst, 0)) {
+                        found(dst);
+                        break;
+                    }
+                    next.emplace_back(dst);
+                }
+                if (answer.witness || (run.result.status != exploration_status::completed))
+                    break;
+                if ((options.max_edges > 0) && (run.result.edges > options.max_edges)) {
+                    stop(run, exploration_status::edge_budget_exceeded);
+                    break;
+                }
+            }
+            if (run.result.status != exploration_status::completed)
+                break;
+            layer.swap(next);
+            next.clear();
+        }
+        run.result.states = parent.size();
+        run.result.memory = memory();
+        run.result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run.begin).count();
+        answer.exploration = run.result;
+        return answer;
+    }
+
+    /**
+     * Keeping only the successors of top in an ample set, if any: the smallest class of dependent transitions that is
+     * not all of them, has no visible labels, and leads to states not visited yet
+     * @return  Number of pruned successors
+     */
+    template <typename Visited>
+    std::size_t reduce(const node_ptr& top, std::vector<std::pair<TransitionLabel, node_ptr>>& successors, Visited&& visited) {
+        const std::size_t N = successors.size();
+        if (!reduction || (N < 2))
+            return 0;
+        // Connected components of the dependency graph
+        std::vector<std::size_t> component(N, N), members;
+        std::size_t best = N, best_size = N;
+        for (std::size_t i = 0; i<N; i++) {
+            if (component[i] != N)
+                continue;
+            members.assign(1, i);
+            component[i] = i;
+            for (std::size_t k = 0; k<members.size(); k++) {
+                const auto& [l1, t1] = successors[members[k]];
+                for (std::size_t j = 0; j<N; j++)
+                    if ((component[j] == N) && !reduction.independent(top, l1, t1, successors[j].first, successors[j].second)) {
+                        component[j] = i;
+                        members.emplace_back(j);
+                    }
+            }
+            if ((members.size() == N) || (members.size() >= best_size))
+                continue;
+            bool ample = true;
+            for (auto j : members) {
+                const auto& [label, dst] = successors[j];
+                if ((reduction.visible && reduction.visible(label)) || visited(dst)) {
+                    ample = false;
+                    break;
+                }
+            }
+            if (ample) {
+                best = i;
+                best_size = members.size();
+            }
+        }
+        if (best == N)
+            return 0;
+        std::size_t kept = 0;
+        for (std::size_t j = 0; j<N; j++)
+            if (component[j] == best)
+                successors[kept++] = std::move(successors[j]);
+        successors.resize(kept);
+        return N - kept;
+    }
+
+    void restart(const node_ptr& root, exploration_run& run) {
+        visited_nodes.clear();
+        forward_transition_graph.clear();
+        frontier.clear();
+        visited_nodes.emplace(root);
+        notify(root);
+        if (checkpoint) {
+            checkpoint->reset();
+            checkpoint->add_state(root);
+        }
+        run.result.status = exploration_status::completed;
+        run.result.edges = run.result.depth = 0;
+    }
+
+    /**
+     * Expanding the given visited states and the ones they reach, as add_root does, and committing the checkpoint
+     */
+    void expand_frontier(std::vector<node_ptr> seeds, exploration_run& run) {
+        if (run.options.strategy == exploration_strategy::breadth_first) {
+            exploration_options unbounded = run.options;
+            unbounded.max_depth = 0;
+            exploration_run bfs{unbounded, run.begin, {}, {}};
+            breadth_first_search(std::move(seeds), bfs);
+            run.result = bfs.result;
+            run.duplicates = bfs.duplicates;
+            run.max_frontier = bfs.max_frontier;
+        } else {
+            std::vector<std::pair<node_ptr, std::size_t>> S;
+            for (auto& t : seeds)
+                S.emplace_back(std::move(t), 0);
+            depth_first_search(std::move(S), run);
+        }
+        if (checkpoint)
+            checkpoint->commit(roots, frontier);
+        run.result.states = visited_nodes.size();
+        run.result.memory = estimated_memory(run.result.edges);
+        run.result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - run.begin).count();
+        summarize(run, frontier.size());
+    }
+
+    /**
+     * Depth-first search from the given visited states, alongside their depth
+     */
+    void depth_first_search(std::vector<std::pair<node_ptr, std::size_t>> S, exploration_run& run) {
+        while (!S.empty()) {
+            auto [top, depth] = std::move(S.back());
+            S.pop_back();
+            run.result.depth = std::max(run.result.depth, depth);
+            if (!expand(top, run, [&S, depth](const node_ptr& dst, bool discovered) {
+                if (discovered)
+                    S.emplace_back(dst, depth + 1);
+            })) {
+                frontier.emplace(std::move(top));
+                for (auto& [t, d] : S)
+                    frontier.emplace(std::move(t));
+                return;
+            }
+            if (checkpoint && checkpoint->expanded()) {
+                std::vector<node_ptr> pending(frontier.begin(), frontier.end());
+                for (const auto& [t, d] : S)
+                    pending.emplace_back(t);
+                checkpoint->commit(roots, pending);
+            }
+            report_progress(run, S.size(), visited_nodes.size());
+        }
+    }
+
+    /**
+     * Breadth-first search from the given layer of visited states
+     */
+    void breadth_first_search(std::vector<node_ptr> layer, exploration_run& run) {
+        std::vector<node_ptr> next;
+        for (std::size_t depth = 0; !layer.empty(); depth++) {
+            run.result.depth = depth;
+            if ((run.options.max_depth > 0) && (depth >= run.options.max_depth)) {
+                run.result.status = exploration_status::depth_bound_reached;
+                frontier.insert(layer.begin(), layer.end());
+                return;
+            }
+            for (auto it = layer.begin(); it != layer.end(); it++) {
+                if (!expand(*it, run, [&next](const node_ptr& dst, bool discovered) {
+                    if (discovered)
+                        next.emplace_back(dst);
+                })) {
+                    frontier.insert(it, layer.end());
+                    frontier.insert(next.begin(), next.end());
+                    return;
+                }
+                if (checkpoint && checkpoint->expanded()) {
+                    std::vector<node_ptr> pending(frontier.begin(), frontier.end());
+                    pending.insert(pending.end(), it + 1, layer.end());
+                    pending.insert(pending.end(), next.begin(), next.end());
+                    checkpoint->commit(roots, pending);
+                }
+                report_progress(run, (layer.end() - it - 1) + next.size(), visited_nodes.size());
+            }
+            layer.swap(next);
+            next.clear();
+        }
+    }
+
+    /**
+     * Depth-first search not expanding the states at distance bound from the root. As a state might be first
+     * discovered through a longer path, it is expanded again whenever it is reached through a shorter one
+     */
+    void bounded_search(const node_ptr& root, std::size_t bound, exploration_run& run) {
+        restart(root, run);
+        std::unordered_map<node_ptr, std::size_t, typename NodeKeys::hasher, typename NodeKeys::equalizer> distance;
+        std::vector<std::pair<node_ptr, std::size_t>> S;
+        distance.emplace(root, 0);
+        S.emplace_back(root, 0);
+        while (!S.empty()) {
+            auto [top, depth] = std::move(S.back());
+            S.pop_back();
+            if (depth > distance.find(top)->second)
+                continue; // Already expanded through a shorter path
+            run.result.depth = std::max(run.result.depth, depth);
+            if (depth >= bound)
+                continue;
+            if (!expand(top, run, [&S, &distance, depth](const node_ptr& dst, bool) {
+                auto [it, discovered] = distance.try_emplace(dst, depth + 1);
+                if (discovered || (it->second > depth + 1)) {
+                    it->second = depth + 1;
+                    S.emplace_back(dst, depth + 1);
+                }
+            })) {
+                frontier.emplace(std::move(top));
+                for (auto& [t, d] : S)
+                    frontier.emplace(std::move(t));
+                break;
+            }
+        }
+        for (const auto& [t, depth] : distance)
+            if (depth >= bound) {
+                if (run.result.status == exploration_status::completed)
+                    run.result.status = exploration_status::depth_bound_reached;
+                frontier.emplace(t);
+            }
     }
 
 };
@@ -0,0 +1,105 @@
+/*
+ * static_language_semantics.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_STATIC_LANGUAGE_SEMANTICS_H
+#define COTT_STATIC_LANGUAGE_SEMANTICS_H
+
+#include <operational_semantics/language_semantics.h>
+#include <tuple>
+
+/**
+ * Rule whose test and transformation are kept with their own type, rather than being erased into a std::function
+ * @tparam Test         Testing condition, with the same signature as the first argument of language_semantics::add_rule
+ * @tparam Transform    Rewriting expression, with the same signature as the second argument of language_semantics::add_rule
+ */
+template <typename Test, typename Transform>
+struct static_rule {
+    Test test;
+    Transform transform;
+};
+
+template <typename Test, typename Transform> static_rule(Test, Transform) -> static_rule<Test, Transform>;
+
+/**
+ * Language semantics whose rules are fixed at compile time, so that the dispatch is generated as a chain of tests
+ * that the compiler can inline, together with the transformations.
+ *
+ * The rules are source-compatible with the ones of language_semantics: as the recursion pointer is this very object,
+ * rules taking a generic (auto*) recursion pointer recursively call the static dispatch, while the rules explicitly
+ * expecting a language_semantics pointer are still supported, but their recursive calls go through the dynamic
+ * dispatch of the base class, which forwards them back to the static one.
+ *
+ * @tparam InputType
+ * @tparam TransitionType
+ * @tparam ResultType
+ * @tparam Rules            Rules by decreasing priority, each of which is a static_rule
+ */
+template <typename InputType,
+        typename TransitionType,
+        typename ResultType,
+        typename... Rules>
+struct static_language_semantics : public language_semantics<InputType,TransitionType,ResultType> {
+
+    explicit static_language_semantics(Rules... r) : rules{std::move(r)...} {
+        // The recursive calls through the base class are forwarded to the static dispatch
+        language_semantics<InputType,TransitionType,ResultType>::add_rule([](const std::shared_ptr<InputType>&) {
+            return true;
+        }, [this](language_semantics<InputType,TransitionType,ResultType>*, const std::shared_ptr<InputType>& t) {
+            return operator()(t);
+        });
+    }
+
+    // The base class holds a rule referring to this object, which cannot therefore be relocated
+    static_language_semantics(const static_language_semantics&) = delete;
+    static_language_semantics& operator=(const static_language_semantics&) = delete;
+
+    /**
+     * Recursive call for all the rules of the language semantics
+     * @param t     Term to be evaluated
+     * @return      Resulting expression from the first rule whose test holds, and an empty vector if no
+     *              rule can be applied
+     */
+    std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> operator()(const std::shared_ptr<InputType>& t) {
+        std::vector<std::pair<TransitionType,std::shared_ptr<ResultType>>> result;
+        std::apply([this, &t, &result](auto&... rule) {
+            (void)((rule.test(t) ? (result = rule.transform(this, t), true) : false) || ...);
+        }, rules);
+        return result;
+    }
+
+private:
+    std::tuple<Rules...> rules;
+};
+
+/**
+ * Creating a static language semantics, while deducing the rule types
+ * @param rules     Rules by decreasing priority, each of which is a static_rule
+ */
+template <typename InputType,
+        typename TransitionType,
+        typename ResultType,
+        typename... Rules>
+static_language_semantics<InputType,TransitionType,ResultType,Rules...> make_static_language_semantics(Rules... rules) {
+    return static_language_semantics<InputType,TransitionType,ResultType,Rules...>(std::move(rules)...);
+}
+
+#endif //COTT_STATIC_LANGUAGE_SEMANTICS_H
@@ -0,0 +1,148 @@
+/*
+ * structural_equality.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_STRUCTURAL_EQUALITY_H
+#define COTT_STRUCTURAL_EQUALITY_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+
+/**
+ * Hash of a term, computed once when first needed. A term embedding it as its hash_cache field has its hash cached by
+ * its std::hash specialisation through get, and KeyEqualizer tells two such terms apart by their cached hashes before
+ * comparing their structure. Copying a term does not copy its cached hash, as the copy is usually modified before
+ * being hashed (e.g., by the rules replacing some children), while a term shall not be modified once hashed.
+ * The hash is stored atomically, as the concurrent explorations hash the shared terms from several threads.
+ */
+struct cached_hash {
+    cached_hash() = default;
+    cached_hash(const cached_hash&) {}
+    cached_hash& operator=(const cached_hash&) {
+        value.store(0, std::memory_order_relaxed);
+        return *this;
+    }
+
+    /**
+     * @return  The cached hash, which is computed by compute if not cached yet
+     */
+    template <typename F>
+    std::size_t get(F&& compute) const {
+        std::size_t h = value.load(std::memory_order_relaxed);
+        if (h)
+            return h;
+        h = compute();
+        // Zero stands for a hash not computed yet, thus a zero hash is computed again each time
+        value.store(h, std::memory_order_relaxed);
+        return h;
+    }
+
+    /**
+     * @return  Whether the terms might be equal, i.e. unless both hashes are cached and they differ
+     */
+    bool may_equal(const cached_hash& rhs) const {
+        std::size_t l = value.load(std::memory_order_relaxed), r = rhs.value.load(std::memory_order_relaxed);
+        return (!l) || (!r) || (l == r);
+    }
+
+private:
+    mutable std::atomic<std::size_t> value{0};
+};
+
+/**
+ * Whether the term caches its hash in a hash_cache field, of type cached_hash
+ */
+template <typename T, typename = void>
+struct has_hash_cache : std::false_type { };
+
+template <typename T>
+struct has_hash_cache<T, std::void_t<decltype(std::declval<const T&>().hash_cache)>>
+        : std::is_same<std::remove_cvref_t<decltype(std::declval<const T&>().hash_cache)>, cached_hash> { };
+
+template <typename T>
+inline constexpr bool has_hash_cache_v = has_hash_cache<T>::value;
+
+/*
+ * Comparing collections of children without allocating: the children of a term are usually few, so that quadratic
+ * scans are cheaper than building sets or maps of them
+ */
+
+/**
+ * @return  Whether the ranges hold the same elements regardless of their order and repetitions, e.g. the branches of
+ *          a choice
+ */
+template <typename It1, typename It2, typename Equal = std::equal_to<>>
+bool unordered_set_equal(It1 lbegin, It1 lend, It2 rbegin, It2 rend, Equal equal = {}) {
+    for (auto l = lbegin; l != lend; l++)
+        if (std::none_of(rbegin, rend, [&](const auto& r) { return equal(*l, r); }))
+            return false;
+    for (auto r = rbegin; r != rend; r++)
+        if (std::none_of(lbegin, lend, [&](const auto& l) { return equal(l, *r); }))
+            return false;
+    return true;
+}
+
+/**
+ * @return  Whether the ranges hold the same elements as often, regardless of their order
+ */
+template <typename It1, typename It2, typename Equal = std::equal_to<>>
+bool unordered_multiset_equal(It1 lbegin, It1 lend, It2 rbegin, It2 rend, Equal equal = {}) {
+    if (std::distance(lbegin, lend) != std::distance(rbegin, rend))
+        return false;
+    for (auto l = lbegin; l != lend; l++) {
+        auto same = [&](const auto& x) { return equal(*l, x); };
+        // Counting each element once, at its first occurrence
+        if (std::find_if(lbegin, l, same) != l)
+            continue;
+        if (std::count_if(l, lend, same) != std::count_if(rbegin, rend, same))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @return  Whether two sorted ranges, e.g. of interned children sorted by pointer, hold the same elements as often
+ */
+template <typename It1, typename It2, typename Equal = std::equal_to<>>
+bool sorted_multiset_equal(It1 lbegin, It1 lend, It2 rbegin, It2 rend, Equal equal = {}) {
+    return std::equal(lbegin, lend, rbegin, rend, equal);
+}
+
+/**
+ * @return  Whether two sorted ranges hold the same elements, regardless of their repetitions
+ */
+template <typename It1, typename It2, typename Equal = std::equal_to<>>
+bool sorted_set_equal(It1 lbegin, It1 lend, It2 rbegin, It2 rend, Equal equal = {}) {
+    while ((lbegin != lend) && (rbegin != rend)) {
+        if (!equal(*lbegin, *rbegin))
+            return false;
+        auto l = lbegin, r = rbegin;
+        while ((++lbegin != lend) && equal(*l, *lbegin));
+        while ((++rbegin != rend) && equal(*r, *rbegin));
+    }
+    return (lbegin == lend) && (rbegin == rend);
+}
+
+#endif //COTT_STRUCTURAL_EQUALITY_H
@@ -0,0 +1,113 @@
+/*
+ * term_arena.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_TERM_ARENA_H
+#define COTT_TERM_ARENA_H
+
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
+
+/**
+ * Region from which terms and results are allocated, together with their shared pointer's control block. Released
+ * terms are recycled for the next allocations, and the whole memory is freed in bulk when the arena is released or
+ * destroyed. Therefore, no term allocated in the arena shall outlive it.
+ *
+ * An arena is used by make_term when it is the current one, i.e. within the lifetime of one of its scopes.
+ */
+struct term_arena : private std::pmr::memory_resource {
+
+    explicit term_arena(std::pmr::pool_options options = {}) : pool{options} {}
+    term_arena(const term_arena&) = delete;
+    term_arena& operator=(const term_arena&) = delete;
+
+    /**
+     * Allocating a term in the arena, together with the control block of its shared pointer
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> make(Args&&... args) {
+        return std::allocate_shared<T>(std::pmr::polymorphic_allocator<T>(this), std::forward<Args>(args)...);
+    }
+
+    /**
+     * Freeing all the memory of the arena in bulk, after all of its terms were released
+     */
+    void release() {
+        pool.release();
+    }
+
+    /**
+     * Making an arena the current one, until the scope ends
+     */
+    struct scope {
+        explicit scope(term_arena& arena) : previous{active} { active = &arena; }
+        ~scope() { active = previous; }
+        scope(const scope&) = delete;
+        scope& operator=(const scope&) = delete;
+    private:
+        term_arena* previous;
+    };
+
+    /**
+     * @return  The current arena of this thread, or null if none
+     */
+    static term_arena* current() {
+        return active;
+    }
+
+    std::size_t allocations = 0;        ///< Number of allocations served by the arena
+    std::size_t allocated_bytes = 0;    ///< Bytes currently allocated from the arena
+    std::size_t max_allocated_bytes = 0;///< Maximum number of bytes allocated at once from the arena
+
+private:
+    std::pmr::unsynchronized_pool_resource pool;
+    static inline thread_local term_arena* active = nullptr;
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        allocations++;
+        allocated_bytes += bytes;
+        max_allocated_bytes = std::max(max_allocated_bytes, allocated_bytes);
+        return pool.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        allocated_bytes -= bytes;
+        pool.deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/**
+ * Creating a new term (or result) from the current arena if any, and through std::make_shared otherwise. Rules should
+ * use this for allocating their results, so that these can be allocated from an arena.
+ */
+template <typename T, typename... Args>
+std::shared_ptr<T> make_term(Args&&... args) {
+    if (term_arena* arena = term_arena::current())
+        return arena->make<T>(std::forward<Args>(args)...);
+    return std::make_shared<T>(std::forward<Args>(args)...);
+}
+
+#endif //COTT_TERM_ARENA_H
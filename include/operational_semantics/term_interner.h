@@ -0,0 +1,204 @@
+/*
+ * term_interner.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_TERM_INTERNER_H
+#define COTT_TERM_INTERNER_H
+
+#include <operational_semantics/key_hasher.h>
+#include <unordered_map>
+#include <vector>
+
+template <typename Term> struct term_interner;
+
+/**
+ * Describing how to intern a term. By default, terms are interned as a whole, by relying on their own hash and
+ * equality. Specialising this for a term type allows to intern its children first, so that the hash and the equality
+ * of a term only have to look at its own fields and at the children's canonical pointers, thus taking a time
+ * independent of the size of the term.
+ * @tparam Term
+ */
+template <typename Term>
+struct interning_traits {
+    static_assert(is_std_hashable_v<Term>, "Error: the term should be hashable, so to be interned");
+    static_assert(CHECK::EqualExists<Term>::value, "Error: the term should come with a default equality predicate, so to be interned");
+
+    /**
+     * Calling f over each (mutable) children of the term, so that these can be replaced by their canonical pointer
+     */
+    template <typename F>
+    static void for_each_child(Term& t, F&& f) {}
+
+    /**
+     * Hashing a term whose children are canonical, whose cached hash can be retrieved from the interner
+     */
+    static std::size_t shallow_hash(const Term& t, const term_interner<Term>& interner) {
+        return std::hash<Term>()(t);
+    }
+
+    /**
+     * Structural equality of two terms whose children are canonical, which can be therefore compared by pointer
+     */
+    static bool shallow_equal(const Term& lhs, const Term& rhs) {
+        return lhs == rhs;
+    }
+};
+
+/**
+ * Hash-consing table, mapping structurally equivalent terms to the same canonical pointer, alongside its hash.
+ * Therefore, canonical terms can be hashed and compared by pointer. Canonical terms are retained as long as the
+ * interner lives, and shall be no further modified.
+ * @tparam Term
+ */
+template <typename Term>
+struct term_interner {
+
+    /**
+     * Retrieving the canonical pointer of a term, which becomes the canonical one if no equivalent term was interned.
+     * The term is not copied: its children, and theirs, are rewritten in place into their canonical pointers, which
+     * are structurally equivalent, so that the caller's term keeps its structure but shares the canonical subterms.
+     * The children are visited without recursion, so that terms of any depth can be interned.
+     * @param t     Term, whose non-canonical subterms are modified
+     * @return      Canonical term structurally equivalent to t
+     */
+    std::shared_ptr<Term> intern(const std::shared_ptr<Term>& t) {
+        if ((!t) || hashes.contains(t.get()))
+            return t;
+        // Each slot holding a non-canonical term is replaced by its canonical one, after the slots of its children
+        std::shared_ptr<Term> root = t;
+        std::vector<std::pair<std::shared_ptr<Term>*, bool>> pending{{&root, false}};
+        while (!pending.empty()) {
+            auto [slot, children_done] = pending.back();
+            pending.pop_back();
+            if ((!*slot) || hashes.contains(slot->get()))
+                continue;
+            if (!children_done) {
+                pending.emplace_back(slot, true);
+                interning_traits<Term>::for_each_child(**slot, [&pending](std::shared_ptr<Term>& child) {
+                    pending.emplace_back(&child, false);
+                });
+            } else {
+                *slot = canonical(*slot);
+            }
+        }
+        return root;
+    }
+    /**
+     * @param t     Canonical term, or null
+     * @return      Cached hash of the term, zero for the null pointer
+     */
+    std::size_t hash(const std::shared_ptr<Term>& t) const {
+        return hash(t.get());
+    }
+
+    /**
+     * @param t     Canonical term, or null
+     * @return      Cached hash of the term, zero for the null pointer
+     */
+    std::size_t hash(const Term* t) const {
+        return t ? hashes.at(t) : 0;
+    }
+
+    /**
+     * @param t     Term
+     * @return      Whether this is a canonical term
+     */
+    bool is_canonical(const std::shared_ptr<Term>& t) const {
+        return (!t) || hashes.contains(t.get());
+    }
+
+    /**
+     * @return  Number of canonical terms
+     */
+    std::size_t size() const {
+        return hashes.size();
+    }
+
+    /**
+     * Forgetting all the canonical terms
+     */
+    void clear() {
+        table.clear();
+        hashes.clear();
+    }
+
+    std::size_t hits = 0;       ///< Number of terms interned as an already existing canonical term
+    std::size_t misses = 0;     ///< Number of terms becoming canonical
+
+private:
+    /**
+     * @return  The canonical pointer of a term whose children are canonical
+     */
+    std::shared_ptr<Term> canonical(const std::shared_ptr<Term>& t) {
+        std::size_t h = interning_traits<Term>::shallow_hash(*t, *this);
+        auto [begin, end] = table.equal_range(h);
+        for (auto it = begin; it != end; it++) {
+            if (interning_traits<Term>::shallow_equal(*it->second, *t)) {
+                hits++;
+                return it->second;
+            }
+        }
+        misses++;
+        table.emplace(h, t);
+        hashes.emplace(t.get(), h);
+        return t;
+    }
+
+    std::unordered_multimap<std::size_t, std::shared_ptr<Term>> table;  ///< Canonical terms by hash
+    std::unordered_map<const Term*, std::size_t> hashes;                ///< Hash of each canonical term
+};
+
+/**
+ * Keys for storing interned terms, which are hashed and compared by pointer
+ * @tparam Node
+ */
+template <typename Node>
+struct interned_keys {
+    struct hasher {
+        std::size_t operator()(const std::shared_ptr<Node>& k) const {
+            return hash_mix(std::hash<const Node*>()(k.get()));
+        }
+    };
+
+    struct equalizer {
+        bool operator()(const std::shared_ptr<Node>& x, const std::shared_ptr<Node>& y) const {
+            return x.get() == y.get();
+        }
+    };
+
+    /**
+     * @return  The canonical pointer of the term, that can be then stored by pointer
+     */
+    std::shared_ptr<Node> canonical(const std::shared_ptr<Node>& t) {
+        return interner.intern(t);
+    }
+
+    /**
+     * Forgetting all the canonical terms
+     */
+    void clear() {
+        interner.clear();
+    }
+
+    term_interner<Node> interner;
+};
+
+#endif //COTT_TERM_INTERNER_H
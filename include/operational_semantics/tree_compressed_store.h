@@ -0,0 +1,318 @@
+/*
+ * tree_compressed_store.h
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+
+#ifndef COTT_TREE_COMPRESSED_STORE_H
+#define COTT_TREE_COMPRESSED_STORE_H
+
+#include <operational_semantics/is_serializable.h>
+#include <operational_semantics/term_interner.h>
+#include <operational_semantics/compact_lts.h>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Hash table of pairs of 32-bit identifiers, numbering each distinct pair densely in order of insertion. The pairs
+ * are stored in a vector, indexed by an open addressing table of their numbers: about 13 bytes per pair.
+ */
+struct pair_table {
+    static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+    pair_table() : slots(1024, none) {}
+
+    /**
+     * @return  The number of the pair, and whether it was newly inserted
+     */
+    std::pair<std::uint32_t, bool> insert(std::uint32_t left, std::uint32_t right) {
+        std::uint64_t key = ((std::uint64_t)left << 32) | right;
+        std::size_t i = slot(key);
+        for (; slots[i] != none; i = (i + 1) & (slots.size() - 1))
+            if (pairs[slots[i]] == key)
+                return {slots[i], false};
+        auto id = (std::uint32_t)pairs.size();
+        pairs.emplace_back(key);
+        slots[i] = id;
+        if (pairs.size() * 4 > slots.size() * 3) {
+            slots.assign(slots.size() * 2, none);
+            for (std::uint32_t p = 0; p<pairs.size(); p++) {
+                std::size_t j = slot(pairs[p]);
+                while (slots[j] != none)
+                    j = (j + 1) & (slots.size() - 1);
+                slots[j] = p;
+            }
+        }
+        return {id, true};
+    }
+
+    std::optional<std::uint32_t> find(std::uint32_t left, std::uint32_t right) const {
+        std::uint64_t key = ((std::uint64_t)left << 32) | right;
+        for (std::size_t i = slot(key); slots[i] != none; i = (i + 1) & (slots.size() - 1))
+            if (pairs[slots[i]] == key)
+                return slots[i];
+        return std::nullopt;
+    }
+
+    std::uint32_t left(std::uint32_t id) const { return (std::uint32_t)(pairs[id] >> 32); }
+    std::uint32_t right(std::uint32_t id) const { return (std::uint32_t)pairs[id]; }
+    std::size_t size() const { return pairs.size(); }
+
+    std::size_t memory() const {
+        return pairs.capacity() * sizeof(std::uint64_t) + slots.capacity() * sizeof(std::uint32_t);
+    }
+
+private:
+    std::size_t slot(std::uint64_t key) const {
+        return (std::size_t)((key * 0x9E3779B97F4A7C15ull) >> 20) & (slots.size() - 1);
+    }
+
+    std::vector<std::uint64_t> pairs;
+    std::vector<std::uint32_t> slots;
+};
+
+/**
+ * In-memory state storage in the style of LTSmin's tree compression, where successive states sharing most of their
+ * subterms take only the space of the subterms that changed. Each distinct subterm is stored once, as a right-nested
+ * list of pairs of identifiers: (shallow, (child_1, (child_2, ... (child_k, none)))), where shallow numbers the
+ * serialization of the subterm without its children, and each child is the identifier of the subterm's list. A state
+ * is then just the identifier of its term. The children are enumerated by interning_traits, and the subterms are
+ * serialized by serialization_traits.
+ *
+ * It has the same interface as disk_state_store, so that small_step_semantics::visit_external generates the graph
+ * into either, while the edges are kept in RAM as lts_transition records.
+ *
+ * @tparam Node
+ * @tparam Label
+ */
+template <typename Node, typename Label>
+struct tree_compressed_store {
+    static_assert(is_serializable_v<Node>, "Error: the node type should be serializable, so to store its subterms");
+
+    using state_id = std::uint32_t;
+    using label_id = std::uint32_t;
+
+    tree_compressed_store() : slots(1024, none) {}
+
+    /**
+     * Storing the state, if no equivalent state was already stored
+     * @return  The identifier of the state, and whether it was newly stored
+     */
+    std::pair<state_id, bool> add_state(const std::shared_ptr<Node>& t) {
+        auto term = encode(t);
+        std::size_t i = slot(term);
+        for (; slots[i] != none; i = (i + 1) & (slots.size() - 1))
+            if (terms[slots[i]] == term)
+                return {slots[i], false};
+        auto id = (state_id)terms.size();
+        terms.emplace_back(term);
+        slots[i] = id;
+        if (terms.size() * 4 > slots.size() * 3) {
+            slots.assign(slots.size() * 2, none);
+            for (state_id s = 0; s<terms.size(); s++) {
+                std::size_t j = slot(terms[s]);
+                while (slots[j] != none)
+                    j = (j + 1) & (slots.size() - 1);
+                slots[j] = s;
+            }
+        }
+        return {id, true};
+    }
+
+    /**
+     * @return  The identifier of the state, if stored. Its subterms are looked up without being stored
+     */
+    std::optional<state_id> find(const std::shared_ptr<Node>& t) {
+        auto term = lookup(t);
+        if (!term)
+            return std::nullopt;
+        for (std::size_t i = slot(*term); slots[i] != none; i = (i + 1) & (slots.size() - 1))
+            if (terms[slots[i]] == *term)
+                return slots[i];
+        return std::nullopt;
+    }
+
+    /**
+     * @return  The state, rebuilt from its subterms, which are shared as in the store. Until the next call, it is kept
+     *          alongside its subterms, so that the ones shared by its successors are not encoded again. Hence, it
+     *          shall not be modified
+     */
+    std::shared_ptr<Node> state(state_id s) {
+        recent.clear();
+        std::unordered_map<std::uint32_t, std::shared_ptr<Node>> decoded;
+        last = decode(terms[s], decoded);
+        return last;
+    }
+
+    label_id add_label(const Label& l) {
+        auto [it, inserted] = label_index.try_emplace(l, (label_id)label_values.size());
+        if (inserted)
+            label_values.emplace_back(l);
+        return it->second;
+    }
+
+    const Label& label(label_id l) const {
+        return label_values[l];
+    }
+
+    void add_edge(state_id src, label_id label, state_id dst) {
+        edges.push_back({src, label, dst});
+    }
+
+    template <typename F>
+    void for_each_edge(F&& f) const {
+        for (const auto& e : edges)
+            f(e);
+    }
+
+    std::size_t state_count() const { return terms.size(); }
+    std::size_t label_count() const { return label_values.size(); }
+    std::size_t edge_count() const { return edges.size(); }
+
+    /**
+     * @return  Number of distinct subterms, and of the pairs storing them
+     */
+    std::size_t subterm_count() const { return subterms; }
+    std::size_t pair_count() const { return nodes.size(); }
+
+    /**
+     * @return  Bytes used by the states, excluding the edges and the labels
+     */
+    std::size_t memory() const {
+        std::size_t shallow_bytes = 0;
+        for (const auto& s : shallow_values)
+            shallow_bytes += sizeof(std::string) + s.capacity();
+        return nodes.memory() + shallow_bytes +
+               shallow_index.size() * (sizeof(typename decltype(shallow_index)::value_type) + 2 * sizeof(void*)) +
+               terms.capacity() * sizeof(std::uint32_t) + slots.capacity() * sizeof(state_id);
+    }
+
+    double bytes_per_state() const {
+        return terms.empty() ? 0.0 : (double)memory() / (double)terms.size();
+    }
+
+    /**
+     * Number of states already expanded, as an exploration expands them in order
+     */
+    std::size_t expanded = 0;
+
+private:
+    static constexpr std::uint32_t none = std::numeric_limits<std::uint32_t>::max();
+
+    std::size_t slot(std::uint32_t term) const {
+        return (std::size_t)(((std::uint64_t)term * 0x9E3779B97F4A7C15ull) >> 20) & (slots.size() - 1);
+    }
+
+    std::uint32_t encode(const std::shared_ptr<Node>& t) {
+        if (!t)
+            return none;
+        if (auto it = recent.find(t.get()); it != recent.end())
+            return it->second;
+        Node shallow = *t;
+        std::vector<std::uint32_t> children;
+        interning_traits<Node>::for_each_child(shallow, [this, &children](std::shared_ptr<Node>& child) {
+            children.emplace_back(encode(child));
+            child = nullptr;
+        });
+        buffer.clear();
+        serialization_traits<Node>::write(shallow, buffer);
+        auto [data, inserted] = shallow_index.try_emplace(buffer, (std::uint32_t)shallow_values.size());
+        if (inserted)
+            shallow_values.emplace_back(buffer);
+        std::uint32_t list = none;
+        for (auto it = children.rbegin(); it != children.rend(); it++)
+            list = nodes.insert(*it, list).first;
+        auto [id, fresh] = nodes.insert(data->second, list);
+        subterms += fresh;
+        return id;
+    }
+
+    /**
+     * As encode, without storing anything
+     * @return  The identifier of the term, or none if any of its subterms is not stored
+     */
+    std::optional<std::uint32_t> lookup(const std::shared_ptr<Node>& t) {
+        if (!t)
+            return none;
+        if (auto it = recent.find(t.get()); it != recent.end())
+            return it->second;
+        Node shallow = *t;
+        std::vector<std::uint32_t> children;
+        bool stored = true;
+        interning_traits<Node>::for_each_child(shallow, [this, &children, &stored](std::shared_ptr<Node>& child) {
+            if (stored) {
+                auto id = lookup(child);
+                stored = id.has_value();
+                children.emplace_back(id.value_or(none));
+            }
+            child = nullptr;
+        });
+        if (!stored)
+            return std::nullopt;
+        buffer.clear();
+        serialization_traits<Node>::write(shallow, buffer);
+        auto data = shallow_index.find(buffer);
+        if (data == shallow_index.end())
+            return std::nullopt;
+        std::uint32_t list = none;
+        for (auto it = children.rbegin(); it != children.rend(); it++) {
+            auto pair = nodes.find(*it, list);
+            if (!pair)
+                return std::nullopt;
+            list = *pair;
+        }
+        return nodes.find(data->second, list);
+    }
+
+    std::shared_ptr<Node> decode(std::uint32_t id, std::unordered_map<std::uint32_t, std::shared_ptr<Node>>& decoded) {
+        if (id == none)
+            return nullptr;
+        if (auto it = decoded.find(id); it != decoded.end())
+            return it->second;
+        const char* in = shallow_values[nodes.left(id)].data();
+        auto t = std::make_shared<Node>(serialization_traits<Node>::read(in));
+        std::uint32_t list = nodes.right(id);
+        interning_traits<Node>::for_each_child(*t, [this, &list, &decoded](std::shared_ptr<Node>& child) {
+            child = decode(nodes.left(list), decoded);
+            list = nodes.right(list);
+        });
+        decoded.emplace(id, t);
+        recent.emplace(t.get(), id);
+        return t;
+    }
+
+    pair_table nodes;
+    std::vector<std::string> shallow_values;
+    std::unordered_map<std::string, std::uint32_t> shallow_index;
+    std::size_t subterms = 0;
+    std::vector<std::uint32_t> terms;           ///< Term of each state
+    std::vector<state_id> slots;                ///< Open addressing table of the states, by term
+    std::shared_ptr<Node> last;                 ///< Last state rebuilt, owning the subterms in recent
+    std::unordered_map<const Node*, std::uint32_t> recent;   ///< Subterms of the last state rebuilt
+    std::string buffer;
+    std::vector<Label> label_values;
+    std::unordered_map<Label, label_id> label_index;
+    std::vector<lts_transition> edges;
+};
+
+#endif //COTT_TREE_COMPRESSED_STORE_H
@@ -0,0 +1,144 @@
+/*
+ * instrumentation_allocator.cpp
+ * This file is part of COtt
+ *
+ * Copyright (C) 2024 - Giacomo Bergami
+ *
+ * COtt is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * COtt is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with COtt. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replacing the global operator new and delete, so that allocation_counters counts the allocations of each thread.
+ * This is opt-in: a program counts its allocations by linking this translation unit, e.g. through the
+ * operational_semantics_allocator CMake target. The whole set of overloads is replaced, so that every allocation is
+ * counted and released by the matching function: the memory is obtained from malloc, or from aligned_alloc for the
+ * over-aligned types, and is freed by free in either case.
+ */
+
+#include <operational_semantics/instrumentation.h>
+#include <cstdlib>
+#include <new>
+
+/**
+ * @return  The allocated memory, or null if it cannot be allocated and no new handler frees any
+ */
+static void* counted_allocation(std::size_t size, std::size_t alignment) noexcept {
+    auto& counters = allocation_counters::local();
+    counters.count++;
+    counters.bytes += size;
+    if (size == 0)
+        size = 1;
+    // aligned_alloc requires the size to be a multiple of the alignment
+    if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        size = (size + alignment - 1) & ~(alignment - 1);
+    while (true) {
+        void* p = (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) ? std::aligned_alloc(alignment, size) : std::malloc(size);
+        if (p)
+            return p;
+        auto handler = std::get_new_handler();
+        if (!handler)
+            return nullptr;
+        try {
+            handler();
+        } catch (...) {
+            return nullptr;
+        }
+    }
+}
+
+static void* counted_allocation_or_throw(std::size_t size, std::size_t alignment) {
+    if (void* p = counted_allocation(size, alignment))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) {
+    return counted_allocation_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](std::size_t size) {
+    return counted_allocation_or_throw(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_allocation_or_throw(size, (std::size_t)alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_allocation_or_throw(size, (std::size_t)alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocation(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return counted_allocation(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_allocation(size, (std::size_t)alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return counted_allocation(size, (std::size_t)alignment);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(p);
+}